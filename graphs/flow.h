@@ -0,0 +1,391 @@
+#if !defined(FLOW_H_)
+#define FLOW_H_
+
+#include <vector>
+#include <map>
+#include <queue>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include "graph.h"
+#include "../sorting/histogram.h"
+
+using namespace std;
+
+/*
+ * Flow network: the residual graph of a weighted graph<T> stored in
+ * compressed sparse row (CSR) form. Edge weights are the capacities.
+ *
+ * Every edge (u, v, c) of the graph adds two arcs:
+ * - the forward arc u -> v with residual capacity c.
+ * - the reverse arc v -> u with residual capacity 0.
+ * The arcs of vertex i are stored in [offset[i], offset[i + 1]) and
+ * rev[a] is the index of the arc paired with arc a.
+ *
+ * The CSR is built once; every call to max_flow() restores the original
+ * capacities, so the same network can answer many (source, sink) queries.
+ *
+ * Max-flow is computed using FIFO push-relabel with the global relabeling
+ * and gap heuristics. Only the first phase (maximum preflow) is run; it is
+ * enough to know the flow value and the minimum cut.
+ */
+template<typename T>
+class flow_network
+{
+private:
+	size_t              _n;         // number of vertices
+	map<T, size_t>      _ids;       // vertex -> dense id
+	vector<T>           _labels;    // dense id -> vertex
+	vector<size_t>      _offset;    // arcs of vertex i: [offset[i], offset[i + 1])
+	vector<size_t>      _head;      // end point of an arc
+	vector<size_t>      _rev;       // the paired (reverse) arc
+	vector<double>      _capacity;  // original capacity of an arc
+	vector<double>      _residual;  // residual capacity of an arc
+
+	// per query state
+	vector<size_t>      _height;    // height (distance label) of a vertex
+	vector<double>      _excess;    // excess flow at a vertex
+	vector<size_t>      _current;   // current arc of a vertex
+	vector<size_t>      _hcount;    // number of vertices at a given height
+	vector<bool>        _queued;    // is the vertex in the active queue?
+	queue<size_t>       _active;    // active vertices (FIFO)
+	vector<bool>        _cut;       // true if a vertex is on the source side
+	size_t              _source;
+	size_t              _sink;
+
+	/*
+	 * Get the dense id of a vertex.
+	 * Throws out_of_range exception if the vertex is not found.
+	 */
+	size_t id(const T &v) const
+	{
+		typename map<T, size_t>::const_iterator it = _ids.find(v);
+		if (it == _ids.end()) {
+			ostringstream oss;
+			oss << "vertex " << v << " not found";
+			throw out_of_range(oss.str());
+		}
+		return it->second;
+	}
+
+	/*
+	 * Add a vertex to the active queue if it has excess and
+	 * can still reach the sink.
+	 */
+	void activate(size_t v)
+	{
+		if ((v != _source) && (v != _sink) && !_queued[v] &&
+			(_excess[v] > 0.0) && (_height[v] < _n)) {
+			_queued[v] = true;
+			_active.push(v);
+		}
+	}
+
+	/*
+	 * Global relabeling. Sets the height of every vertex to its exact
+	 * distance to the sink in the residual graph (reverse BFS from the
+	 * sink). Vertices that cannot reach the sink get height n.
+	 */
+	void global_relabel()
+	{
+		GRAPH_PHASE("global_relabel");
+
+		fill(_height.begin(), _height.end(), _n);
+		fill(_hcount.begin(), _hcount.end(), 0);
+
+		queue<size_t> q;
+		_height[_sink] = 0;
+		q.push(_sink);
+
+		while (!q.empty()) {
+			size_t u = q.front();
+			q.pop();
+
+			for (size_t a = _offset[u]; a < _offset[u + 1]; ++a) {
+				size_t w = _head[a];
+				// w can reach u if the arc w -> u has residual capacity.
+				if ((_residual[_rev[a]] > 0.0) && (_height[w] == _n) && (w != _source)) {
+					_height[w] = _height[u] + 1;
+					q.push(w);
+				}
+			}
+		}
+
+		for (size_t v = 0; v < _n; ++v) {
+			_hcount[_height[v]]++;
+			_current[v] = _offset[v];
+		}
+
+		while (!_active.empty())
+			_active.pop();
+		fill(_queued.begin(), _queued.end(), false);
+		for (size_t v = 0; v < _n; ++v)
+			activate(v);
+	}
+
+	/*
+	 * Gap heuristic. No vertex is left at height h; the vertices above h
+	 * (and below n) can no longer reach the sink. Lift them to n.
+	 */
+	void gap(size_t h)
+	{
+		for (size_t v = 0; v < _n; ++v) {
+			if ((_height[v] > h) && (_height[v] < _n)) {
+				_hcount[_height[v]]--;
+				_height[v] = _n;
+				_hcount[_n]++;
+			}
+		}
+	}
+
+	/*
+	 * Relabel vertex v: lift it to one more than its lowest neighbour
+	 * in the residual graph.
+	 */
+	void relabel(size_t v)
+	{
+		size_t old = _height[v];
+		size_t h = 2 * _n;
+
+		for (size_t a = _offset[v]; a < _offset[v + 1]; ++a) {
+			if ((_residual[a] > 0.0) && (_height[_head[a]] + 1 < h))
+				h = _height[_head[a]] + 1;
+		}
+
+		if (h > _n)
+			h = _n;
+
+		_hcount[old]--;
+		_height[v] = h;
+		_hcount[h]++;
+		_current[v] = _offset[v];
+
+		if ((_hcount[old] == 0) && (old < _n))
+			gap(old);
+	}
+
+	/*
+	 * Push excess flow out of vertex v until it has no excess or
+	 * it can no longer reach the sink.
+	 *
+	 * @return true if v was relabeled.
+	 */
+	bool discharge(size_t v)
+	{
+		bool relabeled = false;
+
+		while ((_excess[v] > 0.0) && (_height[v] < _n)) {
+			if (_current[v] == _offset[v + 1]) {
+				relabel(v);
+				relabeled = true;
+				continue;
+			}
+
+			size_t a = _current[v];
+			size_t w = _head[a];
+
+			if ((_residual[a] > 0.0) && (_height[v] == _height[w] + 1)) {
+				double delta = min(_excess[v], _residual[a]);
+				_residual[a] -= delta;
+				_residual[_rev[a]] += delta;
+				_excess[v] -= delta;
+				_excess[w] += delta;
+				activate(w);
+				if (_excess[v] == 0.0)
+					break;
+			}
+
+			++_current[v];
+		}
+
+		return relabeled;
+	}
+
+	/*
+	 * Mark the source side of the minimum cut: the vertices that
+	 * cannot reach the sink in the residual graph.
+	 */
+	void find_cut()
+	{
+		vector<bool> reaches(_n, false);
+		queue<size_t> q;
+
+		reaches[_sink] = true;
+		q.push(_sink);
+
+		while (!q.empty()) {
+			size_t u = q.front();
+			q.pop();
+
+			for (size_t a = _offset[u]; a < _offset[u + 1]; ++a) {
+				size_t w = _head[a];
+				if ((_residual[_rev[a]] > 0.0) && !reaches[w]) {
+					reaches[w] = true;
+					q.push(w);
+				}
+			}
+		}
+
+		for (size_t v = 0; v < _n; ++v)
+			_cut[v] = !reaches[v];
+	}
+
+public:
+	explicit flow_network(const graph<T> &g)
+		: _n(g.count()), _source(0), _sink(0)
+	{
+		for (auto v : g.vertices()) {
+			T vrtx = v;
+			_ids[vrtx] = _labels.size();
+			_labels.push_back(vrtx);
+		}
+
+		// Count the arcs of every vertex: one per outgoing and incoming edge.
+		_offset.assign(_n + 1, 0);
+		for (auto e : g.edges()) {
+			_offset[id(e->source())]++;
+			_offset[id(e->sink())]++;
+		}
+
+		_offset[_n] = exclusive_prefix_sum(_offset.data(), _n);
+
+		size_t m = _offset[_n];
+		_head.resize(m);
+		_rev.resize(m);
+		_capacity.assign(m, 0.0);
+
+		vector<size_t> next(_offset.begin(), _offset.end() - 1);
+		for (auto e : g.edges()) {
+			size_t u = id(e->source());
+			size_t v = id(e->sink());
+			size_t fwd = next[u]++;
+			size_t bwd = next[v]++;
+
+			_head[fwd] = v;
+			_rev[fwd] = bwd;
+			_capacity[fwd] = max(e->weight(), 0.0);
+
+			_head[bwd] = u;
+			_rev[bwd] = fwd;
+		}
+
+		_residual = _capacity;
+		_height.resize(_n);
+		_excess.resize(_n);
+		_current.resize(_n);
+		_hcount.resize(_n + 1);
+		_queued.resize(_n);
+		_cut.resize(_n);
+	}
+
+	size_t count() const { return _n; }
+	size_t arcs() const { return _head.size(); }
+
+	/*
+	 * Find the maximum flow from vertex, source, to vertex, sink.
+	 *
+	 * @param [in] source the source vertex.
+	 * @param [in] sink   the sink vertex.
+	 *
+	 * @return the value of the maximum flow.
+	 */
+	double max_flow(const T &source, const T &sink)
+	{
+		GRAPH_PHASE("maxflow");
+
+		_source = id(source);
+		_sink = id(sink);
+
+		_residual = _capacity;
+		fill(_excess.begin(), _excess.end(), 0.0);
+		fill(_cut.begin(), _cut.end(), false);
+
+		if (_source == _sink) {
+			_cut[_source] = true;
+			return 0.0;
+		}
+
+		// Saturate all the arcs leaving the source.
+		for (size_t a = _offset[_source]; a < _offset[_source + 1]; ++a) {
+			double c = _residual[a];
+			if (c > 0.0) {
+				_residual[a] = 0.0;
+				_residual[_rev[a]] += c;
+				_excess[_head[a]] += c;
+				_excess[_source] -= c;
+			}
+		}
+
+		global_relabel();
+
+		size_t relabels = 0;
+
+		while (!_active.empty()) {
+			size_t v = _active.front();
+			_active.pop();
+			_queued[v] = false;
+
+			if (discharge(v))
+				relabels++;
+
+			/*
+			 * Exact heights go stale as the flow changes. Recompute
+			 * them once every n relabels.
+			 */
+			if (relabels >= _n) {
+				global_relabel();
+				relabels = 0;
+			}
+		}
+
+		find_cut();
+
+		return _excess[_sink];
+	}
+
+	/*
+	 * Is vertex, v, on the source side of the minimum cut found
+	 * by the last call to max_flow()?
+	 */
+	bool source_side(const T &v) const
+	{
+		return _cut[id(v)];
+	}
+
+	/*
+	 * Get the vertices on the source side of the minimum cut.
+	 */
+	vector<T> source_side() const
+	{
+		vector<T> vertices;
+		for (size_t v = 0; v < _n; ++v) {
+			if (_cut[v])
+				vertices.push_back(_labels[v]);
+		}
+		return vertices;
+	}
+
+	/*
+	 * Get the edges of the minimum cut i.e. the edges going from the
+	 * source side to the sink side. Their capacities add up to the
+	 * maximum flow. There is no cut between a source and itself: the
+	 * list is empty.
+	 */
+	vector<edge<T>> min_cut() const
+	{
+		vector<edge<T>> edges;
+		if (_source == _sink)
+			return edges;
+		for (size_t u = 0; u < _n; ++u) {
+			if (!_cut[u])
+				continue;
+			for (size_t a = _offset[u]; a < _offset[u + 1]; ++a) {
+				if ((_capacity[a] > 0.0) && !_cut[_head[a]])
+					edges.emplace_back(_labels[u], _labels[_head[a]], _capacity[a]);
+			}
+		}
+		return edges;
+	}
+};
+
+#endif // FLOW_H_
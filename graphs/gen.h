@@ -0,0 +1,178 @@
+#if !defined(GEN_H_)
+#define GEN_H_
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <ostream>
+
+using namespace std;
+
+/*
+ * Synthetic graph families.
+ */
+enum graph_family
+{
+	ERDOS_RENYI,    // m edges picked uniformly at random
+	RMAT,           // recursive matrix (Kronecker) graph, skewed degrees
+	GRID,           // 2D grid, every vertex connected to its right and lower neighbour
+	PATH,           // a long path 0 -> 1 -> ... -> n - 1
+	DAG             // complete DAG, i -> j for every i < j
+};
+
+/*
+ * Get the graph family from its name.
+ *
+ * @return true if the name is valid, false otherwise.
+ */
+static bool
+graph_family_from_name(const char *name, graph_family &family)
+{
+	if (strcmp(name, "er") == 0)
+		family = ERDOS_RENYI;
+	else if (strcmp(name, "rmat") == 0)
+		family = RMAT;
+	else if (strcmp(name, "grid") == 0)
+		family = GRID;
+	else if (strcmp(name, "path") == 0)
+		family = PATH;
+	else if (strcmp(name, "dag") == 0)
+		family = DAG;
+	else
+		return false;
+	return true;
+}
+
+/*
+ * Generates a synthetic graph and writes it out in the format read
+ * by graph(istream &):
+ * Line 1: 0|1 (undirected or directed)
+ * Line 2: v1 v2 w1 (two vertices of an edge and its weight)
+ * ...
+ */
+class graph_generator
+{
+private:
+	graph_family    _family;    // graph family
+	size_t          _n;         // number of vertices
+	size_t          _m;         // number of edges (er and rmat only)
+	bool            _directed;  // directed or undirected?
+	int             _wmax;      // weights are picked from [1, wmax]
+	mt19937_64      _rng;       // seeded; the same seed generates the same graph
+
+	int weight()
+	{
+		uniform_int_distribution<int> dist(1, _wmax);
+		return dist(_rng);
+	}
+
+	void edge(ostream &os, size_t from, size_t to)
+	{
+		os << from << ' ' << to << ' ' << weight() << '\n';
+	}
+
+	void erdos_renyi(ostream &os)
+	{
+		uniform_int_distribution<size_t> dist(0, _n - 1);
+
+		for (size_t i = 0; i < _m; ++i) {
+			size_t from = dist(_rng);
+			size_t to = dist(_rng);
+			if (from != to)
+				edge(os, from, to);
+			else
+				--i;
+		}
+	}
+
+	/*
+	 * R-MAT: every edge picks one quadrant of the adjacency matrix
+	 * (probabilities a, b, c, d) at every level of recursion.
+	 */
+	void rmat(ostream &os)
+	{
+		constexpr double a = 0.57, b = 0.19, c = 0.19;
+		uniform_real_distribution<double> dist(0.0, 1.0);
+
+		size_t scale = 0;
+		while ((size_t(1) << scale) < _n)
+			scale++;
+
+		for (size_t i = 0; i < _m; ++i) {
+			size_t from = 0, to = 0;
+
+			for (size_t bit = 0; bit < scale; ++bit) {
+				double p = dist(_rng);
+				from <<= 1;
+				to <<= 1;
+				if (p < a) {
+					// top-left
+				} else if (p < a + b) {
+					to |= 1;
+				} else if (p < a + b + c) {
+					from |= 1;
+				} else {
+					from |= 1;
+					to |= 1;
+				}
+			}
+
+			from %= _n;
+			to %= _n;
+			if (from != to)
+				edge(os, from, to);
+			else
+				--i;
+		}
+	}
+
+	void grid(ostream &os)
+	{
+		size_t side = 1;
+		while (side * side < _n)
+			side++;
+
+		for (size_t r = 0; r < side; ++r) {
+			for (size_t c = 0; c < side; ++c) {
+				size_t v = r * side + c;
+				if (c + 1 < side)
+					edge(os, v, v + 1);
+				if (r + 1 < side)
+					edge(os, v, v + side);
+			}
+		}
+	}
+
+	void path(ostream &os)
+	{
+		for (size_t v = 0; v + 1 < _n; ++v)
+			edge(os, v, v + 1);
+	}
+
+	void dag(ostream &os)
+	{
+		for (size_t i = 0; i < _n; ++i)
+			for (size_t j = i + 1; j < _n; ++j)
+				edge(os, i, j);
+	}
+
+public:
+	graph_generator(graph_family family, size_t n, size_t m, bool dir, int wmax, uint64_t seed)
+		: _family(family), _n(n < 2 ? 2 : n), _m(m), _directed(dir),
+		  _wmax(wmax < 1 ? 1 : wmax), _rng(seed) {}
+
+	void generate(ostream &os)
+	{
+		os << ((_directed || (_family == DAG)) ? "1" : "0") << '\n';
+
+		switch (_family) {
+			case ERDOS_RENYI: erdos_renyi(os); break;
+			case RMAT: rmat(os); break;
+			case GRID: grid(os); break;
+			case PATH: path(os); break;
+			case DAG: dag(os); break;
+		}
+	}
+};
+
+#endif // GEN_H_
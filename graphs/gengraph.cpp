@@ -0,0 +1,72 @@
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include "gen.h"
+
+using namespace std;
+
+static int
+usage(const char *progname)
+{
+	cerr << progname << " -type <er|rmat|grid|path|dag> -n <vertices>" << endl
+		<< "    [-m <edges>]                            Number of edges (er and rmat only, default 8 * n)." << endl
+		<< "    [-directed]                             Generate a directed graph." << endl
+		<< "    [-wmax <weight>]                        Edge weights are in [1, weight] (default 100)." << endl
+		<< "    [-seed <seed>]                          Random seed (default 1)." << endl;
+	return 1;
+}
+
+int
+main(int argc, const char **argv)
+{
+	graph_family family = ERDOS_RENYI;
+	bool have_family = false;
+	size_t n = 0;
+	size_t m = 0;
+	bool directed = false;
+	int wmax = 100;
+	uint64_t seed = 1;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-directed") == 0) {
+			directed = true;
+			continue;
+		}
+
+		if (argv[i + 1] == nullptr) {
+			cerr << "missing argument for " << argv[i] << endl;
+			return usage(argv[0]);
+		}
+
+		if (strcmp(argv[i], "-type") == 0) {
+			if (!graph_family_from_name(argv[++i], family)) {
+				cerr << "invalid graph type " << argv[i] << endl;
+				return usage(argv[0]);
+			}
+			have_family = true;
+		} else if (strcmp(argv[i], "-n") == 0) {
+			n = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-m") == 0) {
+			m = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-wmax") == 0) {
+			wmax = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-seed") == 0) {
+			seed = strtoull(argv[++i], nullptr, 10);
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	if (!have_family || (n == 0)) {
+		cerr << "graph type and number of vertices must be specified." << endl;
+		return usage(argv[0]);
+	}
+
+	if (m == 0)
+		m = 8 * n;
+
+	graph_generator gen(family, n, m, directed, wmax, seed);
+	gen.generate(cout);
+
+	return 0;
+}
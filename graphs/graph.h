@@ -3,12 +3,14 @@
 
 #include <vector>
 #include <set>
+#include <map>
 #include <queue>
 #include <istream>
 #include <ostream>
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include "stats.h"
 
 using namespace std;
 
@@ -130,6 +132,7 @@ private:
 	size_t              _count;         // number of vertices
 	vector<vertex<T>>   _vertices;      // vertices in the graph
 	vector<edge<T> *>   _edges;         // all edges in the graph
+	map<T, size_t>      _ids;           // vertex -> index in _vertices
 
 	/*
 	 * Get a vertex, v.
@@ -137,14 +140,7 @@ private:
 	 */
 	vertex<T> & get_vertex(const T &v)
 	{
-		typename vector<vertex<T>>::iterator it = find(_vertices.begin(), _vertices.end(), v);
-		if (it == _vertices.end()) {
-			ostringstream oss;
-			oss << "vertex " << v << " not found";
-			throw out_of_range(oss.str());
-		} else {
-			return *it;
-		}
+		return _vertices[id(v)];
 	}
 
 	/*
@@ -212,6 +208,8 @@ public:
 		T v1, v2;
 		double w = 0.0;
 
+		GRAPH_PHASE("load");
+
 		_count = 0;
 
 		is >> dir;
@@ -224,6 +222,41 @@ public:
 
 	}
 
+	/*
+	 * The graph owns its edges; it can be moved but not copied.
+	 */
+	graph(const graph<T> &) = delete;
+	graph<T> & operator=(const graph<T> &) = delete;
+
+	graph(graph<T> &&other) noexcept
+		: _directed(other._directed), _count(other._count),
+		  _vertices(std::move(other._vertices)), _edges(std::move(other._edges)),
+		  _ids(std::move(other._ids))
+	{
+		other._count = 0;
+		other._vertices.clear();
+		other._edges.clear();
+		other._ids.clear();
+	}
+
+	graph<T> & operator=(graph<T> &&other)
+	{
+		if (this != &other) {
+			for (auto e : _edges)
+				delete e;
+			_directed = other._directed;
+			_count = other._count;
+			_vertices = std::move(other._vertices);
+			_edges = std::move(other._edges);
+			_ids = std::move(other._ids);
+			other._count = 0;
+			other._vertices.clear();
+			other._edges.clear();
+			other._ids.clear();
+		}
+		return *this;
+	}
+
 	~graph()
 	{
 		typename vector<edge<T> *>::iterator it = _edges.begin();
@@ -239,27 +272,37 @@ public:
 	 */
 	void add_vertex(const T &v)
 	{
-		typename vector<vertex<T>>::iterator it = find(_vertices.begin(), _vertices.end(), v);
-		if (it == _vertices.end()) {
+		if (_ids.end() == _ids.find(v)) {
+			_ids[v] = _vertices.size();
 			_vertices.emplace_back(v);
 			++_count;
 		}
 	}
 
 	/*
-	 * Get a vertex, v.
+	 * Get the dense id of a vertex, v: its position in vertices().
+	 * Vertices are numbered 0 to count() - 1 in insertion order.
 	 * Throws out_of_range exception if the vertex is not found.
 	 */
-	const vertex<T> & get_vertex(const T &v) const
+	size_t id(const T &v) const
 	{
-		typename vector<vertex<T>>::const_iterator it = find(_vertices.begin(), _vertices.end(), v);
-		if (it == _vertices.end()) {
+		GRAPH_STAT(vertex_lookups);
+		typename map<T, size_t>::const_iterator it = _ids.find(v);
+		if (it == _ids.end()) {
 			ostringstream oss;
 			oss << "vertex " << v << " not found";
 			throw out_of_range(oss.str());
-		} else {
-			return *it;
 		}
+		return it->second;
+	}
+
+	/*
+	 * Get a vertex, v.
+	 * Throws out_of_range exception if the vertex is not found.
+	 */
+	const vertex<T> & get_vertex(const T &v) const
+	{
+		return _vertices[id(v)];
 	}
 
 	/*
@@ -305,18 +348,20 @@ public:
 	 */
 	graph<T> reverse() const
 	{
-		graph<T> g(true);
-
-		if (_directed) {
-			for (auto v : _vertices) {
-				typename vector<edge<T> *>::const_iterator it;
-				for (it = v.edges().begin(); it != v.edges().end(); ++it) {
-					const edge<T> *e = *it;
-					g.add_edge(e->sink(), e->source(), e->weight());
-				}
+		GRAPH_PHASE("reverse");
+
+		graph<T> g(_directed);
+
+		/*
+		 * For an undirected graph, both (v1, v2) and (v2, v1) are
+		 * already present; the reversed graph is a copy.
+		 */
+		for (auto &v : _vertices) {
+			typename vector<edge<T> *>::const_iterator it;
+			for (it = v.edges().begin(); it != v.edges().end(); ++it) {
+				const edge<T> *e = *it;
+				g.add_edge(e->sink(), e->source(), e->weight());
 			}
-		} else {
-			g = *this;
 		}
 
 		return g;
@@ -389,6 +434,7 @@ public:
 
 	bool is_visited(const T &v)
 	{
+		GRAPH_STAT(visited_checks);
 		bool b = (visited.end() != visited.find(v));
 #if defined(DEBUG)
 		cout << "is_visited(" << v << ") = " << boolalpha << b << endl;
@@ -407,6 +453,7 @@ public:
 #if defined(DEBUG)
 		cout << "set_visited(" << v << ") = " << boolalpha << val << endl;
 #endif
+		GRAPH_STAT(visited_updates);
 		if (val)
 			visited.insert(v);
 		else
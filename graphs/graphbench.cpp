@@ -0,0 +1,307 @@
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <string>
+#include <chrono>
+#include <iomanip>
+#include "graph.h"
+#include "algorithms.h"
+#include "gen.h"
+#include "reorder.h"
+
+/*
+ * Visitor that does nothing; keeps the output out of the timings.
+ */
+template<typename T>
+class null_visitor : public visitor<T>
+{
+public:
+	null_visitor() {}
+	virtual ~null_visitor() {}
+
+	void pre(const vertex<T> &) {}
+};
+
+enum bench_op
+{
+	LOAD,
+	DFS,
+	BFS,
+	SCC,
+	SSSP,
+	DAG_SSSP,
+	MST_PRIM,
+	MST_KRUSKAL,
+	NUM_OPS
+};
+
+static const char *op_names[NUM_OPS] = {
+	"load", "dfs", "bfs", "scc", "sssp", "dag_sssp", "mst_prim", "mst_kruskal"
+};
+
+/*
+ * Print a result line.
+ */
+static void
+report(const char *name, size_t nv, size_t ne, double usec)
+{
+	double eps = (usec > 0) ? (ne / (usec / 1e6)) : 0.0;
+
+	cout << setw(12) << name << setw(12) << nv << setw(12) << ne
+		<< setw(14) << static_cast<size_t>(usec)
+		<< setw(16) << static_cast<size_t>(eps) << endl;
+}
+
+/*
+ * Time an operation.
+ *
+ * @return the time taken in microseconds.
+ */
+template<typename F>
+static double
+elapsed(F func)
+{
+	chrono::time_point<chrono::high_resolution_clock> start = chrono::high_resolution_clock::now();
+	func();
+	chrono::time_point<chrono::high_resolution_clock> stop = chrono::high_resolution_clock::now();
+	return chrono::duration_cast<chrono::microseconds>(stop - start).count();
+}
+
+/*
+ * Time an operation and print a result line.
+ */
+template<typename F>
+static void
+measure(const char *name, size_t nv, size_t ne, F func)
+{
+	report(name, nv, ne, elapsed(func));
+}
+
+/*
+ * Run the selected operations on the graph read from is.
+ * If relabel is set, the graph is reordered first (see reorder.h).
+ */
+static void
+run(istream &is, const bool *ops, bool relabel, vertex_order order)
+{
+	graph<int> *gp = nullptr;
+
+	// Load is always run; the edge count is known only after the load.
+	double usec = elapsed([&]() { gp = new graph<int>(is); });
+
+	size_t nv = gp->count();
+	size_t ne = gp->edges().size();
+
+	if (ops[LOAD])
+		report(op_names[LOAD], nv, ne, usec);
+
+	/*
+	 * Shortest paths start from the first vertex read, so that
+	 * runs with and without reordering do the same work.
+	 */
+	int start = (nv != 0) ? static_cast<int>(gp->first()) : -1;
+
+	if (relabel && (nv != 0)) {
+		measure("reorder", nv, ne, [&]() {
+			graph<int> *gr = new graph<int>(reorder(*gp, vertex_ordering(*gp, order)));
+			delete gp;
+			gp = gr;
+		});
+	}
+
+	if (nv == 0) {
+		delete gp;
+		return;
+	}
+
+	const graph<int> &g = *gp;
+
+	if (ops[DFS]) {
+		measure(op_names[DFS], nv, ne, [&]() {
+			null_visitor<int> visitor;
+			dfs(g, visitor);
+		});
+	}
+
+	if (ops[BFS]) {
+		measure(op_names[BFS], nv, ne, [&]() {
+			null_visitor<int> visitor;
+			bfs(g, visitor);
+		});
+	}
+
+	// SCC and DAG SSSP need a directed graph.
+	if (ops[SCC] && g.directed()) {
+		measure(op_names[SCC], nv, ne, [&]() {
+			connected_components<int> scc;
+			find_strongly_connected_components(g, scc);
+		});
+	}
+
+	if (ops[SSSP]) {
+		measure(op_names[SSSP], nv, ne, [&]() {
+			shortest_path<int> sp(g, -1);
+			sssp(g, start, sp);
+		});
+	}
+
+	if (ops[DAG_SSSP] && g.directed()) {
+		measure(op_names[DAG_SSSP], nv, ne, [&]() {
+			shortest_path<int> sp(g, -1);
+			dag_sssp(g, start, sp);
+		});
+	}
+
+	// MST needs an undirected graph.
+	if (ops[MST_PRIM] && !g.directed()) {
+		measure(op_names[MST_PRIM], nv, ne, [&]() {
+			mst_prim(g);
+		});
+	}
+
+	if (ops[MST_KRUSKAL] && !g.directed()) {
+		measure(op_names[MST_KRUSKAL], nv, ne, [&]() {
+			mst_kruskal(g);
+		});
+	}
+
+	delete gp;
+}
+
+static int
+usage(const char *progname)
+{
+	cerr << progname << " [-in <file> | -type <er|rmat|grid|path|dag>]" << endl
+		<< "    [-min <exp>]                            Smallest graph has 10^exp vertices (default 3)." << endl
+		<< "    [-max <exp>]                            Largest graph has 10^exp vertices (default 4)." << endl
+		<< "    [-degree <d>]                           Average out-degree for er and rmat (default 8)." << endl
+		<< "    [-directed]                             Generate directed graphs." << endl
+		<< "    [-seed <seed>]                          Random seed (default 1)." << endl
+		<< "    [-reorder <bfs|rcm|degree>]             Relabel the vertices after load." << endl
+		<< "    [-ops <op1,op2,...>]                    Subset of: load, dfs, bfs, scc, sssp, dag_sssp," << endl
+		<< "                                            mst_prim, mst_kruskal (default all)." << endl;
+	return 1;
+}
+
+int
+main(int argc, const char **argv)
+{
+	string file;
+	graph_family family = ERDOS_RENYI;
+	bool have_family = false;
+	int min_exp = 3;
+	int max_exp = 4;
+	size_t degree = 8;
+	bool directed = false;
+	uint64_t seed = 1;
+	bool relabel = false;
+	vertex_order order = ORDER_RCM;
+	bool ops[NUM_OPS];
+
+	for (int i = 0; i < NUM_OPS; ++i)
+		ops[i] = true;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-directed") == 0) {
+			directed = true;
+			continue;
+		}
+
+		if (argv[i + 1] == nullptr) {
+			cerr << "missing argument for " << argv[i] << endl;
+			return usage(argv[0]);
+		}
+
+		if (strcmp(argv[i], "-in") == 0) {
+			file = argv[++i];
+		} else if (strcmp(argv[i], "-type") == 0) {
+			if (!graph_family_from_name(argv[++i], family)) {
+				cerr << "invalid graph type " << argv[i] << endl;
+				return usage(argv[0]);
+			}
+			have_family = true;
+		} else if (strcmp(argv[i], "-min") == 0) {
+			min_exp = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-max") == 0) {
+			max_exp = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-degree") == 0) {
+			degree = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-seed") == 0) {
+			seed = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-reorder") == 0) {
+			++i;
+			if (strcmp(argv[i], "bfs") == 0) {
+				order = ORDER_BFS;
+			} else if (strcmp(argv[i], "rcm") == 0) {
+				order = ORDER_RCM;
+			} else if (strcmp(argv[i], "degree") == 0) {
+				order = ORDER_DEGREE;
+			} else {
+				cerr << "invalid argument for " << argv[i - 1] << endl;
+				return usage(argv[0]);
+			}
+			relabel = true;
+		} else if (strcmp(argv[i], "-ops") == 0) {
+			for (int j = 0; j < NUM_OPS; ++j)
+				ops[j] = false;
+
+			stringstream ss(argv[++i]);
+			while (ss.good()) {
+				string name;
+				getline(ss, name, ',');
+				int j;
+				for (j = 0; j < NUM_OPS; ++j) {
+					if (name == op_names[j]) {
+						ops[j] = true;
+						break;
+					}
+				}
+				if (j == NUM_OPS) {
+					cerr << "invalid operation " << name << endl;
+					return usage(argv[0]);
+				}
+			}
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	if (file.empty() && !have_family) {
+		cerr << "either an input file or a graph type must be specified." << endl;
+		return usage(argv[0]);
+	}
+
+	fstream fin;
+	if (!file.empty()) {
+		fin.open(file, ios_base::in);
+		if (!fin.is_open()) {
+			cerr << "cannot open " << file << endl;
+			return 1;
+		}
+	}
+
+	cout << setw(12) << "op" << setw(12) << "vertices" << setw(12) << "edges"
+		<< setw(14) << "usec" << setw(16) << "edges/sec" << endl;
+
+	if (!file.empty()) {
+		run(fin, ops, relabel, order);
+		return 0;
+	}
+
+	size_t n = 1;
+	for (int e = 0; e < min_exp; ++e)
+		n *= 10;
+
+	for (int e = min_exp; e <= max_exp; ++e, n *= 10) {
+		/*
+		 * The graph is generated in memory in the text format so that
+		 * load measures the same parsing as the graph driver.
+		 */
+		stringstream ss;
+		graph_generator gen(family, n, degree * n, directed, 100, seed);
+		gen.generate(ss);
+		run(ss, ops, relabel, order);
+	}
+
+	return 0;
+}
@@ -0,0 +1,312 @@
+#if !defined(REORDER_H_)
+#define REORDER_H_
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include "graph.h"
+
+using namespace std;
+
+/*
+ * Vertex orderings.
+ *
+ * The traversals visit vertices and allocate edges in the order of
+ * graph::vertices(), which is the order in which vertices were first
+ * seen in the input. Relabeling the vertices so that neighbours get
+ * nearby ids keeps the working set of a traversal small.
+ */
+enum vertex_order
+{
+	ORDER_BFS,      // breadth first order
+	ORDER_RCM,      // reverse Cuthill-McKee; minimizes the bandwidth
+	ORDER_DEGREE    // descending degree; hubs packed together
+};
+
+/*
+ * Get the neighbours of a vertex (by dense id), sorted by degree.
+ */
+template<typename T>
+static void
+neighbours_by_degree(const graph<T> &g, size_t v, vector<size_t> &nbrs)
+{
+	nbrs.clear();
+	for (auto e : g.vertices()[v].edges())
+		nbrs.push_back(g.id(e->sink()));
+
+	sort(nbrs.begin(), nbrs.end(), [&g](size_t a, size_t b) {
+		return g.vertices()[a].degree() < g.vertices()[b].degree();
+	});
+}
+
+/*
+ * Breadth first ordering. Every component is started from its vertex of
+ * minimum degree; neighbours are visited in increasing order of degree
+ * (Cuthill-McKee). The result is a permutation of the dense ids.
+ *
+ * @param [in] g the graph.
+ *
+ * @return vertices (dense ids) in the new order.
+ */
+template<typename T>
+vector<size_t>
+cuthill_mckee_order(const graph<T> &g)
+{
+	size_t n = g.count();
+	vector<size_t> order;
+	vector<bool> visited(n, false);
+	vector<size_t> nbrs;
+
+	// Candidate start vertices: lowest degree first.
+	vector<size_t> starts(n);
+	for (size_t v = 0; v < n; ++v)
+		starts[v] = v;
+	stable_sort(starts.begin(), starts.end(), [&g](size_t a, size_t b) {
+		return g.vertices()[a].degree() < g.vertices()[b].degree();
+	});
+
+	order.reserve(n);
+
+	for (auto s : starts) {
+		if (visited[s])
+			continue;
+
+		/*
+		 * The order vector doubles as the BFS queue:
+		 * order[head, end) are discovered but not yet expanded.
+		 */
+		size_t head = order.size();
+		order.push_back(s);
+		visited[s] = true;
+
+		while (head < order.size()) {
+			size_t v = order[head++];
+			neighbours_by_degree(g, v, nbrs);
+			for (auto w : nbrs) {
+				if (!visited[w]) {
+					visited[w] = true;
+					order.push_back(w);
+				}
+			}
+		}
+	}
+
+	return order;
+}
+
+/*
+ * Compute a vertex order.
+ *
+ * @param [in] g     the graph.
+ * @param [in] which the ordering to use.
+ *
+ * @return vertices (dense ids) in the new order.
+ */
+template<typename T>
+vector<size_t>
+vertex_ordering(const graph<T> &g, vertex_order which)
+{
+	vector<size_t> order;
+
+	switch (which) {
+		case ORDER_BFS:
+			order = cuthill_mckee_order(g);
+			break;
+
+		case ORDER_RCM:
+			order = cuthill_mckee_order(g);
+			std::reverse(order.begin(), order.end());
+			break;
+
+		case ORDER_DEGREE:
+			order.resize(g.count());
+			for (size_t v = 0; v < order.size(); ++v)
+				order[v] = v;
+			stable_sort(order.begin(), order.end(), [&g](size_t a, size_t b) {
+				return g.vertices()[a].degree() > g.vertices()[b].degree();
+			});
+			break;
+	}
+
+	return order;
+}
+
+/*
+ * Relabel the graph. Builds a new graph whose vertices (and their edges)
+ * are inserted in the given order; vertex order[i] gets dense id i.
+ * The vertex values themselves are unchanged.
+ *
+ * @param [in] g     the graph.
+ * @param [in] order vertices (dense ids of g) in the new order.
+ *
+ * @return the relabeled graph.
+ */
+template<typename T>
+graph<T>
+reorder(const graph<T> &g, const vector<size_t> &order)
+{
+	GRAPH_PHASE("reorder");
+
+	graph<T> gr(g.directed());
+
+	for (auto v : order)
+		gr.add_vertex(g.vertices()[v]);
+
+	for (auto v : order) {
+		for (auto e : g.vertices()[v].edges())
+			gr.add_edge(e->source(), e->sink(), e->weight());
+	}
+
+	return gr;
+}
+
+/*
+ * Bandwidth of the graph: the maximum difference between the dense ids
+ * of the two end points of an edge. Smaller is more cache friendly.
+ */
+template<typename T>
+size_t
+bandwidth(const graph<T> &g)
+{
+	size_t bw = 0;
+	for (auto e : g.edges()) {
+		size_t u = g.id(e->source());
+		size_t v = g.id(e->sink());
+		bw = max(bw, (u > v) ? (u - v) : (v - u));
+	}
+	return bw;
+}
+
+/*
+ * Split the graph into k parts of roughly equal size.
+ *
+ * - The vertices are laid out in breadth first (Cuthill-McKee) order, so
+ *   neighbours are close to each other.
+ * - The order is cut into k contiguous pieces of equal work, where the work
+ *   of a vertex is 1 + its degree.
+ * - A few refinement passes then move boundary vertices to the part holding
+ *   most of their neighbours, as long as the target part does not grow
+ *   beyond 3% over the average.
+ *
+ * @param [in] g the graph.
+ * @param [in] k number of parts.
+ *
+ * @return part[i] is the part (0 to k - 1) of the vertex with dense id i.
+ */
+template<typename T>
+vector<size_t>
+partition_graph(const graph<T> &g, size_t k)
+{
+	constexpr int passes = 4;
+	size_t n = g.count();
+	vector<size_t> part(n, 0);
+
+	if ((k <= 1) || (n == 0))
+		return part;
+
+	vector<size_t> order = cuthill_mckee_order(g);
+
+	size_t total = 0;
+	for (auto &v : g.vertices())
+		total += 1 + v.degree();
+
+	vector<size_t> load(k, 0);
+	size_t p = 0;
+	size_t done = 0;
+	for (auto v : order) {
+		size_t w = 1 + g.vertices()[v].degree();
+		// Move on to the next part once this one has its share.
+		if ((p + 1 < k) && ((done + w / 2) * k >= total * (p + 1)))
+			p++;
+		part[v] = p;
+		load[p] += w;
+		done += w;
+	}
+
+	size_t limit = (total + k - 1) / k;
+	limit += limit * 3 / 100;
+
+	vector<size_t> links(k, 0);
+
+	for (int pass = 0; pass < passes; ++pass) {
+		size_t moved = 0;
+
+		for (auto v : order) {
+			const vertex<T> &vrtx = g.vertices()[v];
+			size_t from = part[v];
+			size_t w = 1 + vrtx.degree();
+
+			fill(links.begin(), links.end(), 0);
+			for (auto e : vrtx.edges())
+				links[part[g.id(e->sink())]]++;
+
+			size_t best = from;
+			for (size_t q = 0; q < k; ++q) {
+				if ((links[q] > links[best]) && (load[q] + w <= limit))
+					best = q;
+			}
+
+			if (best != from) {
+				part[v] = best;
+				load[from] -= w;
+				load[best] += w;
+				moved++;
+			}
+		}
+
+		if (moved == 0)
+			break;
+	}
+
+	return part;
+}
+
+/*
+ * Number of edges whose end points are in different parts.
+ */
+template<typename T>
+size_t
+edge_cut(const graph<T> &g, const vector<size_t> &part)
+{
+	size_t cut = 0;
+	for (auto e : g.edges()) {
+		if (part[g.id(e->source())] != part[g.id(e->sink())])
+			cut++;
+	}
+	return g.directed() ? cut : cut / 2;
+}
+
+/*
+ * Split the graph into its parts. Every part becomes an independent graph
+ * holding the vertices of the part and the edges between them; the edges
+ * that cross parts are dropped (see edge_cut()).
+ *
+ * @param [in] g    the graph.
+ * @param [in] part the part of every vertex, as returned by partition_graph().
+ * @param [in] k    number of parts.
+ *
+ * @return the k sub-graphs.
+ */
+template<typename T>
+vector<graph<T>>
+split(const graph<T> &g, const vector<size_t> &part, size_t k)
+{
+	vector<graph<T>> parts;
+
+	parts.reserve(k);
+	for (size_t p = 0; p < k; ++p)
+		parts.emplace_back(g.directed());
+
+	for (size_t v = 0; v < g.count(); ++v) {
+		graph<T> &sub = parts[part[v]];
+		sub.add_vertex(g.vertices()[v]);
+		for (auto e : g.vertices()[v].edges()) {
+			if (part[g.id(e->sink())] == part[v])
+				sub.add_edge(e->source(), e->sink(), e->weight());
+		}
+	}
+
+	return parts;
+}
+
+#endif // REORDER_H_
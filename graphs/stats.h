@@ -0,0 +1,144 @@
+#if !defined(STATS_H_)
+#define STATS_H_
+
+/*
+ * Hot-path instrumentation for the graph algorithms.
+ *
+ * Compiled in only when GRAPH_STATS is defined (make DEFINES=-DGRAPH_STATS).
+ * Otherwise GRAPH_STAT() and GRAPH_PHASE() expand to nothing and cost
+ * nothing at run time.
+ *
+ * GRAPH_STAT(counter)  increments one of the graph_stats counters.
+ * GRAPH_PHASE("name")  times the enclosing scope and adds it to the
+ *                      named phase.
+ */
+
+#if defined(GRAPH_STATS)
+
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <iomanip>
+
+using namespace std;
+
+struct graph_stats
+{
+	struct phase
+	{
+		string      name;
+		uint64_t    calls;
+		uint64_t    usec;
+	};
+
+	uint64_t        vertex_lookups = 0;     // vertex -> id lookups
+	uint64_t        vertices_settled = 0;   // vertices processed by a traversal
+	uint64_t        edges_scanned = 0;      // adjacency entries looked at
+	uint64_t        edges_relaxed = 0;      // shortest path entries improved
+	uint64_t        heap_pushes = 0;        // priority queue pushes
+	uint64_t        heap_pops = 0;          // priority queue pops
+	uint64_t        visited_checks = 0;     // visitor::is_visited() calls
+	uint64_t        visited_updates = 0;    // visitor::set_visited() calls
+	vector<phase>   phases;                 // wall time per phase
+
+	static graph_stats & instance()
+	{
+		static graph_stats stats;
+		return stats;
+	}
+
+	void add_phase(const char *name, uint64_t usec)
+	{
+		for (auto &p : phases) {
+			if (p.name == name) {
+				p.calls++;
+				p.usec += usec;
+				return;
+			}
+		}
+		phases.push_back({ name, 1, usec });
+	}
+
+	/*
+	 * Print the statistics, one per line.
+	 */
+	void dump(ostream &os) const
+	{
+		os << "vertex lookups   : " << vertex_lookups << endl
+			<< "vertices settled : " << vertices_settled << endl
+			<< "edges scanned    : " << edges_scanned << endl
+			<< "edges relaxed    : " << edges_relaxed << endl
+			<< "heap pushes      : " << heap_pushes << endl
+			<< "heap pops        : " << heap_pops << endl
+			<< "visited checks   : " << visited_checks << endl
+			<< "visited updates  : " << visited_updates << endl;
+
+		for (auto &p : phases) {
+			os << "phase " << setw(16) << left << p.name << right
+				<< ": " << p.usec << " usec (" << p.calls << " calls)" << endl;
+		}
+	}
+
+	/*
+	 * Print the statistics as a JSON object.
+	 */
+	void dump_json(ostream &os) const
+	{
+		os << "{\"vertex_lookups\": " << vertex_lookups
+			<< ", \"vertices_settled\": " << vertices_settled
+			<< ", \"edges_scanned\": " << edges_scanned
+			<< ", \"edges_relaxed\": " << edges_relaxed
+			<< ", \"heap_pushes\": " << heap_pushes
+			<< ", \"heap_pops\": " << heap_pops
+			<< ", \"visited_checks\": " << visited_checks
+			<< ", \"visited_updates\": " << visited_updates
+			<< ", \"phases\": [";
+
+		for (size_t i = 0; i < phases.size(); ++i) {
+			if (i != 0)
+				os << ", ";
+			os << "{\"name\": \"" << phases[i].name << "\", \"calls\": " << phases[i].calls
+				<< ", \"usec\": " << phases[i].usec << "}";
+		}
+
+		os << "]}" << endl;
+	}
+};
+
+/*
+ * Times its own lifetime and adds it to the named phase.
+ */
+class stats_phase
+{
+private:
+	const char *                                        _name;
+	chrono::time_point<chrono::high_resolution_clock>   _start;
+
+public:
+	explicit stats_phase(const char *name)
+		: _name(name), _start(chrono::high_resolution_clock::now()) {}
+
+	~stats_phase()
+	{
+		chrono::time_point<chrono::high_resolution_clock> stop = chrono::high_resolution_clock::now();
+		graph_stats::instance().add_phase(_name,
+			chrono::duration_cast<chrono::microseconds>(stop - _start).count());
+	}
+};
+
+#define GRAPH_STAT_CONCAT_(a, b)    a ## b
+#define GRAPH_STAT_CONCAT(a, b)     GRAPH_STAT_CONCAT_(a, b)
+
+#define GRAPH_STAT(counter)         (graph_stats::instance().counter++)
+#define GRAPH_PHASE(name)           stats_phase GRAPH_STAT_CONCAT(stats_phase_, __LINE__)(name)
+
+#else // !GRAPH_STATS
+
+#define GRAPH_STAT(counter)
+#define GRAPH_PHASE(name)
+
+#endif // GRAPH_STATS
+
+#endif // STATS_H_
@@ -1,5 +1,6 @@
 #include <memory>
 #include <vector>
+#include <unordered_map>
 #include <algorithm>
 
 using namespace std;
@@ -28,20 +29,22 @@ private:
 	// All the nodes.
 	vector<unique_ptr<ufnode<T>>> nodes;
 
+	// The node of every element.
+	unordered_map<T, ufnode<T> *> index;
+
 	/*
 	 * Find the node. If the node does not exist, add it.
 	 * @return pointer to the node.
 	 */
 	ufnode<T> *find_node(const T &n)
 	{
-		for (size_t i = 0; i < nodes.size(); ++i) {
-			if (nodes[i]->value == n) {
-				return nodes[i].get();
-			}
-		}
+		auto it = index.find(n);
+		if (it != index.end())
+			return it->second;
 
 		ufnode<T> *nptr = new ufnode<T>(n);
 		nodes.emplace_back(nptr);
+		index.emplace(n, nptr);
 		return nptr;
 	}
 
@@ -0,0 +1,147 @@
+#if !defined(ARGSORT_H_)
+#define ARGSORT_H_
+
+#include <vector>
+#include <type_traits>
+#include <cstdint>
+#include "radix.h"
+#include "sort.h"
+
+using namespace std;
+
+/*
+ * A key and the index of the element it was taken from. Sorting these
+ * instead of the elements moves a few bytes per element, however large
+ * the elements are.
+ *
+ * Equal keys are ordered by index, so that every engine gives the same
+ * order, the stable one.
+ */
+template<typename K, typename I>
+struct key_index
+{
+	K key;
+	I index;
+};
+
+template<typename K, typename I>
+inline bool
+operator<(const key_index<K, I> &a, const key_index<K, I> &b)
+{
+	/*
+	 * 32-bit integer keys and indices: compare both at once, as one
+	 * 64-bit integer, without branches.
+	 */
+	if constexpr (is_integral<K>::value && (sizeof(K) == 4) && (sizeof(I) == 4)) {
+		uint64_t x = (uint64_t(radix_key(a.key)) << 32) | a.index;
+		uint64_t y = (uint64_t(radix_key(b.key)) << 32) | b.index;
+		return x < y;
+	}
+
+	if (a.key < b.key)
+		return true;
+	if (b.key < a.key)
+		return false;
+	return a.index < b.index;
+}
+
+/*
+ * How the (key, index) pairs are sorted:
+ * - KEY_RADIX: LSD radix sort on the key (integer keys only).
+ * - KEY_QUICK: intro sort.
+ * - KEY_AUTO:  KEY_RADIX for integer keys, KEY_QUICK otherwise.
+ */
+enum key_engine
+{
+	KEY_AUTO,
+	KEY_RADIX,
+	KEY_QUICK
+};
+
+/*
+ * Sort (key, index) pairs with the given engine. The radix sort is stable,
+ * and the pairs start in index order, so it needs no tie break.
+ */
+template<typename K, typename I>
+void
+key_index_sort(vector<key_index<K, I>> &pairs, key_engine engine = KEY_AUTO)
+{
+	if constexpr (is_integral<K>::value) {
+		if (engine != KEY_QUICK) {
+			lsd_radix_sort_by(pairs, [](const key_index<K, I> &p) { return p.key; });
+			return;
+		}
+	}
+
+	intro_sort(pairs);
+}
+
+/*
+ * Argsort: the permutation that sorts values on key(value).
+ *
+ * @param [in]    values   - the values; they are not moved.
+ * @param [in]    key      - returns the key of a value.
+ * @param [in]    engine   - how to sort the keys.
+ *
+ * @return perm such that values[perm[0]], values[perm[1]], ... are sorted;
+ *         values with equal keys are in their original order.
+ */
+template<typename I = size_t, typename T, typename F>
+vector<I>
+argsort_by(const vector<T> &values, F key, key_engine engine = KEY_AUTO)
+{
+	typedef typename decay<decltype(key(values[0]))>::type K;
+
+	size_t n = values.size();
+	vector<key_index<K, I>> pairs(n);
+	vector<I> perm(n);
+
+	for (size_t i = 0; i < n; ++i)
+		pairs[i] = { key(values[i]), static_cast<I>(i) };
+
+	key_index_sort(pairs, engine);
+
+	for (size_t i = 0; i < n; ++i)
+		perm[i] = pairs[i].index;
+	return perm;
+}
+
+/*
+ * Argsort of values that are their own keys.
+ */
+template<typename I = size_t, typename T>
+vector<I>
+argsort(const vector<T> &values, key_engine engine = KEY_AUTO)
+{
+	return argsort_by<I>(values, [](const T &v) -> const T & { return v; }, engine);
+}
+
+/*
+ * Sort values on key(value), moving every value once: the keys are
+ * sorted with their indices (32-bit ones when there are few enough
+ * values), and the permutation is then applied in place
+ * (apply_permutation(), in radix.h). For records much larger than
+ * their keys this moves far less data than sorting the records. The sort
+ * is stable.
+ *
+ * @param [inout] values   - the vector to sort.
+ * @param [in]    key      - returns the key of a value.
+ * @param [in]    engine   - how to sort the keys.
+ */
+template<typename T, typename F>
+void
+sort_by_key(vector<T> &values, F key, key_engine engine = KEY_AUTO)
+{
+	if (values.size() <= 1)
+		return;
+
+	if (values.size() <= UINT32_MAX) {
+		vector<uint32_t> perm = argsort_by<uint32_t>(values, key, engine);
+		apply_permutation(values, perm);
+	} else {
+		vector<size_t> perm = argsort_by<size_t>(values, key, engine);
+		apply_permutation(values, perm);
+	}
+}
+
+#endif // ARGSORT_H_
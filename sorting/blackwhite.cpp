@@ -1,6 +1,7 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include "kway.h"
 
 using namespace std;
 
@@ -17,29 +18,18 @@ v2s(const vector<int> &a)
 }
 
 /*
- * Invariant for n numbers:
- * - a[0, lo] is white (0)
- * - a[hi + 1, n) is black(1)
- * - a[lo + 1, hi] is unknown
- * Start: lo = 0, hi = n - 1
- * End: lo == hi, a[0, lo] is white, a[hi + 1, n - 1] is black.
+ * Put the white (0) elements before the black (1) ones with a 2-way
+ * partition (see kway_partition() in kway.h); anything but white counts
+ * as black.
  */
 static void
 sortbw(vector<int> &a)
 {
 	int white = 0;
-	int lo = 0;
-	int hi = static_cast<int>(a.size() - 1);
+	vector<size_t> bounds = kway_partition(a, 2, [white](int v) { return v != white; });
 
-	while (lo < hi) {
-		if (a[lo] == white)
-			lo++;
-		else
-			swap(a[lo], a[hi--]);
-	} 
-
-	cout << "lo = " << lo << ", a[lo] = " << a[lo] << endl;
-	cout << "hi + 1 = " << hi + 1 << ", a[hi + 1] = " << a[hi + 1] << endl;
+	cout << "white = [" << bounds[0] << ", " << bounds[1] << ")" << endl;
+	cout << "black = [" << bounds[1] << ", " << bounds[2] << ")" << endl;
 }
 
 int
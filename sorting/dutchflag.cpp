@@ -1,6 +1,7 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include "kway.h"
 
 using namespace std;
 
@@ -17,31 +18,18 @@ v2s(const vector<int> &a)
 }
 
 /*
- * Invariant for n numbers:
- * - a[0, lo - 1] is 0
- * - a[lo, mid - 1] is 1
- * - a[mid, hi] is unknown
- * - a[hi + 1, n - 1] is 2
- * Start: lo = 0, mid = 0, hi = n - 1
+ * Sort a flag of 0s, 1s and 2s with a 3-way partition: the value is the
+ * category (see kway_partition() in kway.h). Values below 0 count as 0,
+ * values above 2 as 2.
  */
 void
 sort_dutch_flag(vector<int> &flag)
 {
-	int lo = 0;
-	int mid = 0;
-	int hi = static_cast<int>(flag.size() - 1);
+	vector<size_t> bounds = kway_partition(flag, 3, [](int v) { return (v > 0) + (v > 1); });
 
-	while (mid < hi) {
-		switch (flag[mid]) {
-			case 0: swap(flag[lo++], flag[mid++]); break;
-			case 1: mid++; break;
-			case 2: default: swap(flag[mid], flag[hi--]); break;
-		}
-	}
-
-	cout << "lo = " << lo << ", flag[lo] = " << flag[lo] << endl;
-	cout << "mid = " << mid << ", flag[mid] = " << flag[mid] << endl;
-	cout << "hi + 1 = " << hi + 1 << ", flag[hi + 1] = " << flag[hi + 1] << endl;
+	cout << "0s = [" << bounds[0] << ", " << bounds[1] << ")" << endl;
+	cout << "1s = [" << bounds[1] << ", " << bounds[2] << ")" << endl;
+	cout << "2s = [" << bounds[2] << ", " << bounds[3] << ")" << endl;
 }
 
 int
@@ -0,0 +1,447 @@
+#if !defined(EXTERNAL_H_)
+#define EXTERNAL_H_
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <unistd.h>
+#include "parallel.h"
+#include "input.h"
+
+using namespace std;
+
+/*
+ * How values are read from the input (text, whitespace separated), kept
+ * in the run files (binary) and written to the final output (text, one
+ * value per line), and how much memory one takes.
+ */
+template<typename T>
+struct run_codec;
+
+template<>
+struct run_codec<int>
+{
+	template<typename F>
+	static bool scan(const char *p, const char *e, F func)
+	{
+		return scan_ints(p, e, func);
+	}
+
+	static size_t size(const int &)
+	{
+		return sizeof(int);
+	}
+
+	static void put(vector<char> &buf, const int &v)
+	{
+		const char *p = reinterpret_cast<const char *>(&v);
+		buf.insert(buf.end(), p, p + sizeof(v));
+	}
+
+	static bool get(FILE *fp, int &v)
+	{
+		return fread(&v, sizeof(v), 1, fp) == 1;
+	}
+
+	static void put_text(vector<char> &buf, const int &v)
+	{
+		char tmp[16];
+		char *end = to_chars(tmp, tmp + sizeof(tmp), v).ptr;
+		*end++ = '\n';
+		buf.insert(buf.end(), tmp, end);
+	}
+};
+
+template<>
+struct run_codec<string>
+{
+	template<typename F>
+	static bool scan(const char *p, const char *e, F func)
+	{
+		return scan_strings(p, e, [&](const char *b, const char *q) { func(string(b, q)); });
+	}
+
+	static size_t size(const string &s)
+	{
+		return sizeof(string) + ((s.capacity() > 15) ? s.capacity() : 0);
+	}
+
+	static void put(vector<char> &buf, const string &s)
+	{
+		uint32_t len = static_cast<uint32_t>(s.size());
+		const char *p = reinterpret_cast<const char *>(&len);
+		buf.insert(buf.end(), p, p + sizeof(len));
+		buf.insert(buf.end(), s.begin(), s.end());
+	}
+
+	static bool get(FILE *fp, string &s)
+	{
+		uint32_t len;
+		if (fread(&len, sizeof(len), 1, fp) != 1)
+			return false;
+		s.resize(len);
+		return fread(&s[0], 1, len, fp) == len;
+	}
+
+	static void put_text(vector<char> &buf, const string &s)
+	{
+		buf.insert(buf.end(), s.begin(), s.end());
+		buf.push_back('\n');
+	}
+};
+
+/*
+ * Write-behind output: the caller fills buffer(), and every full block is
+ * written by a background task while the caller fills the next one. A
+ * null file discards the output.
+ */
+class block_writer
+{
+private:
+	FILE *_fp;
+	size_t _block;
+	vector<char> _buf;
+	future<vector<char>> _pending;
+
+	void wait(vector<char> &spare)
+	{
+		if (_pending.valid()) {
+			spare = _pending.get();
+			spare.clear();
+		}
+	}
+
+public:
+	block_writer(FILE *fp, size_t block) : _fp(fp), _block(block)
+	{
+		_buf.reserve(_block);
+	}
+
+	~block_writer()
+	{
+		if (_pending.valid())
+			_pending.wait();
+	}
+
+	vector<char> &buffer()
+	{
+		return _buf;
+	}
+
+	void flush_if_full()
+	{
+		if (_buf.size() >= _block)
+			flush();
+	}
+
+	void flush()
+	{
+		vector<char> spare;
+
+		if ((_fp == nullptr) || _buf.empty()) {
+			_buf.clear();
+			return;
+		}
+
+		wait(spare);
+		_pending = async(launch::async, [](FILE *fp, vector<char> data) {
+			if (fwrite(data.data(), 1, data.size(), fp) != data.size())
+				throw runtime_error("write failed");
+			return data;
+		}, _fp, move(_buf));
+
+		_buf = move(spare);
+		_buf.reserve(_block);
+	}
+
+	void finish()
+	{
+		vector<char> spare;
+
+		flush();
+		wait(spare);
+		if (_fp != nullptr)
+			fflush(_fp);
+	}
+};
+
+/*
+ * Read-ahead input of a run file: block() holds the current block of
+ * values, and the next one is read by a background task while the caller
+ * consumes it.
+ */
+template<typename T>
+class run_reader
+{
+private:
+	FILE *_fp;
+	size_t _block;
+	vector<T> _cur;
+	future<vector<T>> _next;
+
+	static vector<T> read_block(FILE *fp, size_t n, vector<T> buf)
+	{
+		T v;
+
+		buf.clear();
+		while ((buf.size() < n) && run_codec<T>::get(fp, v))
+			buf.push_back(move(v));
+		return buf;
+	}
+
+public:
+	run_reader(FILE *fp, size_t block) : _fp(fp), _block(block)
+	{
+		_cur = read_block(_fp, _block, vector<T>());
+		if (!_cur.empty())
+			_next = async(launch::async, read_block, _fp, _block, vector<T>());
+	}
+
+	~run_reader()
+	{
+		if (_next.valid())
+			_next.wait();
+	}
+
+	vector<T> &block()
+	{
+		return _cur;
+	}
+
+	/*
+	 * Move on to the next block. Returns false at the end of the run, in
+	 * which case block() is left as it was.
+	 */
+	bool advance()
+	{
+		if (!_next.valid())
+			return false;
+
+		vector<T> next = _next.get();
+		if (next.empty())
+			return false;
+
+		swap(_cur, next);
+		_next = async(launch::async, read_block, _fp, _block, move(next));
+		return true;
+	}
+};
+
+/*
+ * An unnamed temporary file in dir, removed as soon as it is closed.
+ */
+inline FILE *
+external_tmpfile(const string &dir)
+{
+	string path = dir + "/sortrunXXXXXX";
+	int fd = mkstemp(&path[0]);
+
+	if (fd < 0)
+		throw runtime_error("cannot create a temporary file in " + dir);
+
+	unlink(path.c_str());
+
+	FILE *fp = fdopen(fd, "w+b");
+	if (fp == nullptr) {
+		close(fd);
+		throw runtime_error("cannot open a temporary file in " + dir);
+	}
+	return fp;
+}
+
+/*
+ * Merge the sorted runs into out, in binary (an intermediate run) or text
+ * (the final output) form, with a loser tree over one block per run. The
+ * run files are closed.
+ *
+ * @param [in]    runs  - the run files, positioned at their start.
+ * @param [in]    block - values per read block.
+ * @param [inout] out   - where the merged values go.
+ * @param [in]    text  - whether to write text rather than binary.
+ */
+template<typename T>
+void
+external_merge(const vector<FILE *> &runs, size_t block, block_writer &out, bool text)
+{
+	size_t k = runs.size();
+	vector<unique_ptr<run_reader<T>>> readers;
+	loser_tree<T> tree(k);
+
+	for (size_t i = 0; i < k; ++i) {
+		readers.emplace_back(new run_reader<T>(runs[i], block));
+		vector<T> &b = readers[i]->block();
+		tree.set_run(i, b.data(), b.data() + b.size());
+	}
+	tree.build();
+
+	while (!tree.empty()) {
+		size_t w = tree.winner();
+
+		if (text)
+			run_codec<T>::put_text(out.buffer(), tree.top());
+		else
+			run_codec<T>::put(out.buffer(), tree.top());
+		out.flush_if_full();
+
+		if ((tree.left(w) > 1) || !readers[w]->advance()) {
+			tree.pop();
+		} else {
+			vector<T> &b = readers[w]->block();
+			tree.refill(b.data(), b.data() + b.size());
+		}
+	}
+
+	readers.clear();
+	for (FILE *fp : runs)
+		fclose(fp);
+}
+
+/*
+ * Most runs merged at once (open files, and blocks that still fit in the
+ * memory budget).
+ */
+constexpr size_t external_fanin = 128;
+
+/*
+ * External merge sort, for inputs larger than memory.
+ *
+ * The input is cut into runs of about mem / (nthreads + 1) bytes. Each run
+ * is sorted and written to a temporary file by a background task while the
+ * next one is read, with at most nthreads of them at a time, so that about
+ * mem bytes are in use. The runs are then merged, at most
+ * external_fanin at a time; with more runs than that, groups of them are
+ * first merged into longer runs. Run files are read ahead and the output
+ * is written behind, a block at a time, and all of the buffers together
+ * take about mem bytes too.
+ *
+ * The input is streamed a block at a time (see scan_file()). A token that
+ * is not a value of type T is an error, not the end of the input.
+ *
+ * @param [in]    path     - the input file, whitespace separated values.
+ * @param [in]    out      - the output file, one value per line (nullptr to
+ *                           discard the output).
+ * @param [in]    mem      - the memory budget in bytes.
+ * @param [in]    nthreads - number of runs sorted at a time (0: one per core).
+ * @param [in]    tmpdir   - where to put the run files.
+ *
+ * @return the number of values sorted.
+ */
+template<typename T>
+size_t
+external_sort(const string &path, FILE *out, size_t mem, size_t nthreads, const string &tmpdir)
+{
+	if (nthreads == 0)
+		nthreads = default_threads();
+
+	size_t budget = max<size_t>(mem / (nthreads + 1), 1 << 16);
+	size_t count = 0;
+	size_t bytes = 0;
+	size_t used = 0;
+	vector<FILE *> runs;
+	deque<future<void>> inflight;
+	vector<T> run;
+
+	auto spill = [&]() {
+		FILE *fp = external_tmpfile(tmpdir);
+		runs.push_back(fp);
+
+		if (inflight.size() == nthreads) {
+			inflight.front().get();
+			inflight.pop_front();
+		}
+
+		inflight.push_back(async(launch::async, [](FILE *fp, vector<T> run) {
+			sort(run.begin(), run.end());
+
+			block_writer w(fp, 1 << 20);
+			for (const T &x : run) {
+				run_codec<T>::put(w.buffer(), x);
+				w.flush_if_full();
+			}
+			w.finish();
+			rewind(fp);
+		}, fp, move(run)));
+
+		run = vector<T>();
+		used = 0;
+	};
+
+	auto add = [&](T v) {
+		size_t sz = run_codec<T>::size(v);
+		used += sz;
+		bytes += sz;
+		count++;
+		run.push_back(move(v));
+		if (used >= budget)
+			spill();
+	};
+
+	if (!scan_file(path, [&](const char *b, const char *e) { return run_codec<T>::scan(b, e, add); })) {
+		for (auto &f : inflight)
+			f.wait();
+		for (FILE *fp : runs)
+			fclose(fp);
+		throw runtime_error("cannot read " + path + ", or invalid input in it");
+	}
+
+	if (runs.empty()) {
+		/*
+		 * Everything fit in memory.
+		 */
+		sort(run.begin(), run.end());
+
+		block_writer w(out, max<size_t>(mem / 2, 1 << 16));
+		for (const T &x : run) {
+			run_codec<T>::put_text(w.buffer(), x);
+			w.flush_if_full();
+		}
+		w.finish();
+		return count;
+	}
+
+	if (!run.empty())
+		spill();
+
+	for (auto &f : inflight)
+		f.get();
+	inflight.clear();
+
+	/*
+	 * Two blocks per run being merged (the current one and the one read
+	 * ahead) and two for the output.
+	 */
+	size_t avg = max<size_t>(bytes / count, 1);
+
+	while (runs.size() > external_fanin) {
+		vector<FILE *> group(runs.begin(), runs.begin() + external_fanin);
+		runs.erase(runs.begin(), runs.begin() + external_fanin);
+
+		size_t slice = mem / (2 * group.size() + 2);
+		FILE *fp = external_tmpfile(tmpdir);
+		block_writer w(fp, max<size_t>(slice, 1 << 12));
+
+		external_merge<T>(group, max<size_t>(slice / avg, 64), w, false);
+		w.finish();
+		rewind(fp);
+		runs.push_back(fp);
+	}
+
+	size_t slice = mem / (2 * runs.size() + 2);
+	block_writer w(out, max<size_t>(slice, 1 << 12));
+
+	external_merge<T>(runs, max<size_t>(slice / avg, 64), w, true);
+	w.finish();
+
+	return count;
+}
+
+#endif // EXTERNAL_H_
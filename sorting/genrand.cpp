@@ -1,18 +1,136 @@
 #include <iostream>
+#include <vector>
 #include <random>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include "prng.h"
+#include "parallel.h"
+
+using namespace std;
 
 /*
- * Usage: genrand <count>
+ * Values generated by one stream. Chunk c has the generator of the seed
+ * jumped c + 1 times, so the output does not depend on the number of
+ * threads.
  */
+constexpr uint64_t genrand_chunk = 1 << 20;
+
+static int
+usage(const char *progname)
+{
+	cerr << progname << " <count> [-max <m>] [-seed <seed>] [-threads <n>] [-binary] [-out <file>]" << endl
+		<< "    -max <m>        Values are drawn from [0, m] (default count)." << endl
+		<< "    -seed <seed>    Random seed (default a random one)." << endl
+		<< "    -threads <n>    Number of threads (default one per core)." << endl
+		<< "    -binary         Write 32-bit integers in native byte order (default text," << endl
+		<< "                    one value per line)." << endl
+		<< "    -out <file>     Output file (default stdout)." << endl;
+	return 1;
+}
+
 int
-main(int, const char **argv)
+main(int argc, const char **argv)
 {
-	int n = atoi(argv[1]);
-	std::random_device rd;
-	std::uniform_int_distribution<int> dist(0, n);
+	if ((argc < 2) || (argv[1][0] == '-'))
+		return usage(argv[0]);
+
+	uint64_t n = strtoull(argv[1], nullptr, 10);
+	uint64_t range = n;
+	uint64_t seed = random_device()();
+	size_t nthreads = 0;
+	bool binary = false;
+	const char *out = nullptr;
+
+	for (int i = 2; i < argc; ++i) {
+		if (strcmp(argv[i], "-binary") == 0) {
+			binary = true;
+			continue;
+		}
+
+		if (argv[i + 1] == nullptr) {
+			cerr << "missing argument for " << argv[i] << endl;
+			return usage(argv[0]);
+		}
+
+		if (strcmp(argv[i], "-max") == 0) {
+			range = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-seed") == 0) {
+			seed = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-threads") == 0) {
+			nthreads = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-out") == 0) {
+			out = argv[++i];
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	if (range > INT32_MAX) {
+		cerr << "the values must fit in 32 bits" << endl;
+		return usage(argv[0]);
+	}
+
+	FILE *fp = (out == nullptr) ? stdout : fopen(out, "wb");
+	if (fp == nullptr) {
+		cerr << "cannot open " << out << endl;
+		return 1;
+	}
+
+	if (nthreads == 0)
+		nthreads = default_threads();
+
+	/*
+	 * Every round, each thread fills the buffer of a chunk, and the
+	 * buffers are written in order.
+	 */
+	uint64_t nchunks = (n + genrand_chunk - 1) / genrand_chunk;
+	vector<vector<char>> bufs(nthreads);
+	xoshiro256pp base(seed);
+	bool ok = true;
+
+	for (uint64_t first = 0; ok && (first < nchunks); first += nthreads) {
+		size_t count = min<uint64_t>(nthreads, nchunks - first);
+		vector<xoshiro256pp> gens = prng_streams(base, count);
+
+		base = gens.back();
+		run_parallel(count, [&](size_t t) {
+			uint64_t c = first + t;
+			uint64_t len = min(genrand_chunk, n - c * genrand_chunk);
+			vector<char> &buf = bufs[t];
+			xoshiro256pp &gen = gens[t];
+
+			if (binary) {
+				buf.resize(len * sizeof(int32_t));
+				int32_t *p = reinterpret_cast<int32_t *>(buf.data());
+				for (uint64_t i = 0; i < len; ++i)
+					p[i] = static_cast<int32_t>(uniform_below(gen, range + 1));
+			} else {
+				buf.resize(len * 12);
+				char *p = buf.data();
+				for (uint64_t i = 0; i < len; ++i) {
+					p = to_chars(p, p + 11, uniform_below(gen, range + 1)).ptr;
+					*p++ = '\n';
+				}
+				buf.resize(p - buf.data());
+			}
+		});
+
+		for (size_t t = 0; t < count; ++t) {
+			if (fwrite(bufs[t].data(), 1, bufs[t].size(), fp) != bufs[t].size())
+				ok = false;
+		}
+	}
+
+	if ((fflush(fp) != 0) || !ok) {
+		cerr << "write failed" << endl;
+		return 1;
+	}
 
-	for (int i = 0; i < n; ++i)
-		std::cout << dist(rd) << std::endl;
+	if (fp != stdout)
+		fclose(fp);
 
 	return 0;
 }
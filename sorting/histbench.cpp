@@ -0,0 +1,215 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include "histogram.h"
+#include "prng.h"
+
+using namespace std;
+
+/*
+ * Bucket of a 32-bit key among k: multiply and shift, so that any k works
+ * and no division is needed.
+ */
+static inline size_t
+bucket_of(uint32_t key, size_t k)
+{
+	return static_cast<size_t>((static_cast<uint64_t>(key) * k) >> 32);
+}
+
+/*
+ * One histogram, one increment per key.
+ */
+static void
+count_plain(const uint32_t *keys, size_t lo, size_t hi, size_t k, size_t *hist)
+{
+	for (size_t i = lo; i < hi; ++i)
+		hist[bucket_of(keys[i], k)]++;
+}
+
+/*
+ * Four histograms, so that repeated buckets do not make every increment
+ * wait for the previous one; they are added up at the end.
+ */
+static void
+count_interleaved(const uint32_t *keys, size_t lo, size_t hi, size_t k, size_t *hist)
+{
+	vector<size_t> h(4 * k, 0);
+	size_t *h0 = h.data();
+	size_t *h1 = h0 + k;
+	size_t *h2 = h1 + k;
+	size_t *h3 = h2 + k;
+	size_t i = lo;
+
+	for (; i + 4 <= hi; i += 4) {
+		h0[bucket_of(keys[i], k)]++;
+		h1[bucket_of(keys[i + 1], k)]++;
+		h2[bucket_of(keys[i + 2], k)]++;
+		h3[bucket_of(keys[i + 3], k)]++;
+	}
+
+	for (; i < hi; ++i)
+		h0[bucket_of(keys[i], k)]++;
+
+	for (size_t j = 0; j < 4; ++j)
+		simd_add_counts(hist, h0 + j * k, k);
+}
+
+/*
+ * Run func reps times and print the average time per item. func returns
+ * the number of items it processed.
+ */
+template<typename F>
+static void
+measure(const char *name, size_t k, int reps, F func)
+{
+	double usec = 0;
+	size_t items = 0;
+
+	for (int r = 0; r < reps; ++r) {
+		chrono::time_point<chrono::high_resolution_clock> start = chrono::high_resolution_clock::now();
+		items = func();
+		chrono::time_point<chrono::high_resolution_clock> stop = chrono::high_resolution_clock::now();
+
+		usec += chrono::duration_cast<chrono::nanoseconds>(stop - start).count() / 1000.0;
+	}
+
+	cout << setw(12) << name << setw(12) << items << setw(8) << k
+		<< setw(12) << fixed << setprecision(3) << (usec * 1000 / (static_cast<double>(items) * reps)) << endl;
+}
+
+static int
+usage(const char *progname)
+{
+	cerr << progname << " [-n <count>] [-k <buckets>] [-reps <count>] [-threads <n>] [-seed <seed>] [-one]" << endl
+		<< "    -n <count>      Number of 32-bit keys (default 10000000)." << endl
+		<< "    -k <buckets>    Number of buckets (default 256)." << endl
+		<< "    -reps <count>   Repetitions per kernel (default 5)." << endl
+		<< "    -threads <n>    Threads of the parallel kernels (default one per core)." << endl
+		<< "    -seed <seed>    Random seed (default 1)." << endl
+		<< "    -one            All the keys fall in one bucket (default uniform keys)." << endl;
+	return 1;
+}
+
+int
+main(int argc, const char **argv)
+{
+	size_t n = 10000000;
+	size_t k = 256;
+	int reps = 5;
+	size_t nthreads = 0;
+	uint64_t seed = 1;
+	bool one = false;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-one") == 0) {
+			one = true;
+			continue;
+		}
+
+		if (argv[i + 1] == nullptr) {
+			cerr << "missing argument for " << argv[i] << endl;
+			return usage(argv[0]);
+		}
+
+		if (strcmp(argv[i], "-n") == 0) {
+			n = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-k") == 0) {
+			k = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-reps") == 0) {
+			reps = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-threads") == 0) {
+			nthreads = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-seed") == 0) {
+			seed = strtoull(argv[++i], nullptr, 10);
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	if ((n < 1) || (k < 1) || (reps < 1))
+		return usage(argv[0]);
+
+	if (nthreads == 0)
+		nthreads = default_threads();
+
+	xoshiro256pp gen(seed);
+	vector<uint32_t> keys(n);
+
+	for (auto &v : keys)
+		v = one ? 0 : static_cast<uint32_t>(gen() >> 32);
+
+	/*
+	 * Every histogram kernel must give the totals of the plain one.
+	 */
+	vector<size_t> expected(k, 0);
+	vector<size_t> total(k);
+	vector<size_t> count;
+	bool ok = true;
+
+	count_plain(keys.data(), 0, n, k, expected.data());
+
+	cout << setw(12) << "kernel" << setw(12) << "items" << setw(8) << "k"
+		<< setw(12) << "ns/item" << endl;
+
+	measure("plain", k, reps, [&]() {
+		parallel_histogram(n, k, 1, [&](size_t lo, size_t hi, size_t *hist) {
+			count_plain(keys.data(), lo, hi, k, hist);
+		}, count);
+		ok = ok && (count == expected);
+		return n;
+	});
+
+	measure("interleaved", k, reps, [&]() {
+		parallel_histogram(n, k, 1, [&](size_t lo, size_t hi, size_t *hist) {
+			count_interleaved(keys.data(), lo, hi, k, hist);
+		}, count);
+		ok = ok && (count == expected);
+		return n;
+	});
+
+	measure("parallel", k, reps, [&]() {
+		parallel_histogram(n, k, nthreads, [&](size_t lo, size_t hi, size_t *hist) {
+			count_interleaved(keys.data(), lo, hi, k, hist);
+		}, count);
+		histogram_total(count.data(), nthreads, k, total.data());
+		ok = ok && (total == expected);
+		return n;
+	});
+
+	/*
+	 * The scans, per counter: the bucket starts of one histogram, and the
+	 * scatter offsets of nthreads histograms. They work in place; after
+	 * the first repetition they scan their own output, which costs the
+	 * same.
+	 */
+	vector<size_t> starts = expected;
+	vector<size_t> bounds(k + 1);
+
+	ok = ok && (exclusive_prefix_sum(starts.data(), k) == n);
+	measure("scan", k, reps, [&]() {
+		exclusive_prefix_sum(starts.data(), k);
+		return k;
+	});
+
+	parallel_histogram(n, k, nthreads, [&](size_t lo, size_t hi, size_t *hist) {
+		count_plain(keys.data(), lo, hi, k, hist);
+	}, count);
+	scatter_offsets(count.data(), nthreads, k, bounds.data());
+	ok = ok && (bounds[k] == n) && (count[0] == 0);
+
+	measure("offsets", k, reps, [&]() {
+		scatter_offsets(count.data(), nthreads, k, bounds.data());
+		return nthreads * k;
+	});
+
+	if (!ok) {
+		cerr << "a kernel gave wrong counts" << endl;
+		return 1;
+	}
+
+	return 0;
+}
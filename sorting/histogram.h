@@ -0,0 +1,140 @@
+#if !defined(HISTOGRAM_H_)
+#define HISTOGRAM_H_
+
+#include <vector>
+#include <algorithm>
+#include "parallel.h"
+#include "simd.h"
+
+using namespace std;
+
+/*
+ * Counting primitives shared by the counting sorts: the radix sorts
+ * (radix.h), the k-way partition (kway.h) and the CSR builders of the
+ * graphs.
+ *
+ * A counting sort counts the keys in every bucket, turns the counts into
+ * bucket starts with an exclusive prefix sum, then moves every element to
+ * the next free slot of its bucket. With threads, the input is split into
+ * one chunk per thread and every thread keeps its own histogram, so the
+ * counting needs no atomic operation; the per-thread histograms are laid
+ * out one after the other, count[t * k + b] for bucket b of chunk t.
+ * Giving chunk t the slots of bucket b after those of the chunks before it
+ * keeps the scatter stable, and lets every thread scatter its own chunk.
+ */
+
+constexpr size_t histogram_grain = 1 << 16;     // fewest elements worth a thread
+
+/*
+ * Number of threads for counting n elements: nthreads (0: one per core),
+ * but no more than one per histogram_grain elements.
+ */
+inline size_t
+histogram_threads(size_t n, size_t nthreads)
+{
+	if (nthreads == 0)
+		nthreads = default_threads();
+	return max<size_t>(1, min(nthreads, n / histogram_grain));
+}
+
+/*
+ * The chunk of thread t: [lo, hi) of [0, n) split into nthreads chunks.
+ */
+inline void
+histogram_chunk(size_t n, size_t nthreads, size_t t, size_t &lo, size_t &hi)
+{
+	size_t chunk = (n + nthreads - 1) / nthreads;
+
+	lo = min(n, t * chunk);
+	hi = min(n, lo + chunk);
+}
+
+/*
+ * Count n elements into k buckets with nthreads threads.
+ *
+ * @param [in]    n        - the number of elements.
+ * @param [in]    k        - the number of buckets.
+ * @param [in]    nthreads - the number of threads (at least 1).
+ * @param [in]    count_fn - count_fn(lo, hi, hist) adds the buckets of
+ *                           elements [lo, hi) to hist[0, k).
+ * @param [out]   count    - the nthreads histograms, count[t * k + b].
+ */
+template<typename F>
+void
+parallel_histogram(size_t n, size_t k, size_t nthreads, F count_fn, vector<size_t> &count)
+{
+	count.assign(nthreads * k, 0);
+
+	run_parallel(nthreads, [&](size_t t) {
+		size_t lo, hi;
+		histogram_chunk(n, nthreads, t, lo, hi);
+		count_fn(lo, hi, &count[t * k]);
+	});
+}
+
+/*
+ * Add up nthreads histograms of k buckets into total[0, k), vector by
+ * vector (see simd_add_counts()).
+ */
+inline void
+histogram_total(const size_t *count, size_t nthreads, size_t k, size_t *total)
+{
+	copy(count, count + k, total);
+	for (size_t t = 1; t < nthreads; ++t)
+		simd_add_counts(total, count + t * k, k);
+}
+
+/*
+ * Exclusive prefix sum in place: count[b] becomes start plus the sum of
+ * count[0, b).
+ *
+ * @return start plus the sum of all the counts.
+ */
+inline size_t
+exclusive_prefix_sum(size_t *count, size_t k, size_t start = 0)
+{
+	size_t sum = start;
+
+	for (size_t b = 0; b < k; ++b) {
+		size_t tmp = count[b];
+		count[b] = sum;
+		sum += tmp;
+	}
+
+	return sum;
+}
+
+/*
+ * Turn nthreads histograms into scatter offsets: count[t * k + b] becomes
+ * the first slot of bucket b for chunk t, after the slots of the chunks
+ * before t.
+ *
+ * @param [inout] count    - the histograms (see parallel_histogram()).
+ * @param [in]    nthreads - the number of histograms.
+ * @param [in]    k        - the number of buckets.
+ * @param [out]   bounds   - k + 1 entries; bucket b is [bounds[b], bounds[b + 1]).
+ */
+inline void
+scatter_offsets(size_t *count, size_t nthreads, size_t k, size_t *bounds)
+{
+	histogram_total(count, nthreads, k, bounds);
+	bounds[k] = exclusive_prefix_sum(bounds, k);
+
+	if (nthreads == 1) {
+		copy(bounds, bounds + k, count);
+		return;
+	}
+
+	vector<size_t> next(bounds, bounds + k);
+
+	for (size_t t = 0; t < nthreads; ++t) {
+		size_t *c = count + t * k;
+		for (size_t b = 0; b < k; ++b) {
+			size_t tmp = c[b];
+			c[b] = next[b];
+			next[b] += tmp;
+		}
+	}
+}
+
+#endif // HISTOGRAM_H_
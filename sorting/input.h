@@ -0,0 +1,329 @@
+#if !defined(INPUT_H_)
+#define INPUT_H_
+
+#include <vector>
+#include <string>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "parallel.h"
+
+using namespace std;
+
+/*
+ * The contents of a file: mapped into memory, or read into a buffer when
+ * the file cannot be mapped (a pipe, for example).
+ */
+class input_file
+{
+private:
+	const char *_data;
+	size_t _size;
+	bool _mapped;
+	bool _ok;
+	vector<char> _buf;
+
+public:
+	explicit input_file(const string &path) : _data(nullptr), _size(0), _mapped(false), _ok(false)
+	{
+		int fd = open(path.c_str(), O_RDONLY);
+		struct stat st;
+
+		if (fd < 0)
+			return;
+
+		if ((fstat(fd, &st) == 0) && S_ISREG(st.st_mode)) {
+			_size = st.st_size;
+			if (_size == 0) {
+				_ok = true;
+			} else {
+				void *p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (p != MAP_FAILED) {
+					madvise(p, _size, MADV_SEQUENTIAL);
+					_data = static_cast<const char *>(p);
+					_mapped = true;
+					_ok = true;
+				}
+			}
+		}
+
+		if (!_ok) {
+			char block[1 << 16];
+			ssize_t n;
+
+			while ((n = read(fd, block, sizeof(block))) > 0)
+				_buf.insert(_buf.end(), block, block + n);
+			_data = _buf.data();
+			_size = _buf.size();
+			_ok = (n == 0);
+		}
+
+		close(fd);
+	}
+
+	~input_file()
+	{
+		if (_mapped)
+			munmap(const_cast<char *>(_data), _size);
+	}
+
+	input_file(const input_file &) = delete;
+	input_file &operator=(const input_file &) = delete;
+
+	bool ok() const
+	{
+		return _ok;
+	}
+
+	const char *begin() const
+	{
+		return _data;
+	}
+
+	const char *end() const
+	{
+		return _data + _size;
+	}
+
+	size_t size() const
+	{
+		return _size;
+	}
+};
+
+/*
+ * Whitespace, as operator>> skips it.
+ */
+inline bool
+input_space(char c)
+{
+	return (c == ' ') || (c == '\n') || (c == '\t') || (c == '\r') || (c == '\v') || (c == '\f');
+}
+
+/*
+ * Call func(v) for every whitespace separated integer v in [p, e).
+ *
+ * @return false if there is anything else.
+ */
+template<typename F>
+bool
+scan_ints(const char *p, const char *e, F func)
+{
+	for (;;) {
+		while ((p < e) && input_space(*p))
+			p++;
+		if (p == e)
+			return true;
+
+		int v;
+		from_chars_result r = from_chars(p, e, v);
+		if ((r.ec != errc()) || ((r.ptr < e) && !input_space(*r.ptr)))
+			return false;
+
+		func(v);
+		p = r.ptr;
+	}
+}
+
+/*
+ * Call func(begin, end) for every whitespace separated string in [p, e).
+ */
+template<typename F>
+bool
+scan_strings(const char *p, const char *e, F func)
+{
+	for (;;) {
+		while ((p < e) && input_space(*p))
+			p++;
+		if (p == e)
+			return true;
+
+		const char *q = p;
+		while ((q < e) && !input_space(*q))
+			q++;
+
+		func(p, q);
+		p = q;
+	}
+}
+
+/*
+ * Parse the whitespace separated integers in [p, e) into values.
+ *
+ * @return false if there is anything else.
+ */
+inline bool
+parse_ints(const char *p, const char *e, vector<int> &values)
+{
+	return scan_ints(p, e, [&](int v) { values.push_back(v); });
+}
+
+/*
+ * Split [p, e) into whitespace separated strings.
+ */
+inline bool
+parse_strings(const char *p, const char *e, vector<string> &values)
+{
+	return scan_strings(p, e, [&](const char *b, const char *q) { values.emplace_back(b, q); });
+}
+
+/*
+ * Smallest part of the input worth a thread of its own.
+ */
+constexpr size_t input_chunk = 1 << 20;
+
+/*
+ * Parse [b, e) with parse(), in parts cut at whitespace, one per thread.
+ * The parts are parsed into vectors of their own and then moved into
+ * values, in order.
+ *
+ * @param [in]    b        - start of the text.
+ * @param [in]    e        - end of the text.
+ * @param [out]   values   - the parsed values.
+ * @param [in]    nthreads - number of threads (0: one per core).
+ * @param [in]    parse    - parses a part, returns false on bad input.
+ *
+ * @return false if any part has bad input.
+ */
+template<typename T, typename F>
+bool
+parse_parallel(const char *b, const char *e, vector<T> &values, size_t nthreads, F parse)
+{
+	if (nthreads == 0)
+		nthreads = default_threads();
+	nthreads = max<size_t>(min<size_t>(nthreads, (e - b) / input_chunk), 1);
+
+	vector<const char *> bounds(nthreads + 1);
+	vector<vector<T>> parts(nthreads);
+	vector<char> ok(nthreads);
+	vector<size_t> offset(nthreads + 1, 0);
+
+	bounds[0] = b;
+	bounds[nthreads] = e;
+	for (size_t t = 1; t < nthreads; ++t) {
+		const char *p = max(b + (e - b) / nthreads * t, bounds[t - 1]);
+		while ((p < e) && !input_space(*p))
+			p++;
+		bounds[t] = p;
+	}
+
+	run_parallel(nthreads, [&](size_t t) {
+		ok[t] = parse(bounds[t], bounds[t + 1], parts[t]);
+	});
+
+	for (size_t t = 0; t < nthreads; ++t) {
+		if (!ok[t])
+			return false;
+		offset[t + 1] = offset[t] + parts[t].size();
+	}
+
+	if (nthreads == 1) {
+		values = move(parts[0]);
+		return true;
+	}
+
+	values.resize(offset[nthreads]);
+	run_parallel(nthreads, [&](size_t t) {
+		move(parts[t].begin(), parts[t].end(), values.begin() + offset[t]);
+		vector<T>().swap(parts[t]);
+	});
+
+	return true;
+}
+
+/*
+ * Read a file a block at a time and call func(begin, end) on the text of
+ * each block, cut at whitespace so that no value is split. Unlike
+ * input_file, the memory used does not grow with the file, and the file
+ * may be a pipe.
+ *
+ * @return false if the file cannot be read or func() returns false.
+ */
+template<typename F>
+bool
+scan_file(const string &path, F func)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	vector<char> buf(input_chunk);
+	size_t carry = 0;
+	bool ok = (fd >= 0);
+
+	while (ok) {
+		ssize_t n = read(fd, buf.data() + carry, buf.size() - carry);
+		if (n < 0) {
+			ok = false;
+			break;
+		}
+
+		size_t len = carry + n;
+		if (n == 0) {
+			ok = (len == 0) || func(buf.data(), buf.data() + len);
+			break;
+		}
+
+		size_t cut = len;
+		while ((cut > 0) && !input_space(buf[cut - 1]))
+			cut--;
+
+		if (cut == 0) {
+			/*
+			 * A value longer than the block.
+			 */
+			carry = len;
+			if (len == buf.size())
+				buf.resize(2 * buf.size());
+			continue;
+		}
+
+		ok = func(buf.data(), buf.data() + cut);
+		memmove(buf.data(), buf.data() + cut, len - cut);
+		carry = len - cut;
+	}
+
+	if (fd >= 0)
+		close(fd);
+	return ok;
+}
+
+/*
+ * Read whitespace separated integers.
+ */
+inline bool
+read_ints(const input_file &in, vector<int> &values, size_t nthreads)
+{
+	return parse_parallel(in.begin(), in.end(), values, nthreads,
+		[](const char *p, const char *e, vector<int> &v) { return parse_ints(p, e, v); });
+}
+
+/*
+ * Read whitespace separated strings.
+ */
+inline bool
+read_strings(const input_file &in, vector<string> &values, size_t nthreads)
+{
+	return parse_parallel(in.begin(), in.end(), values, nthreads,
+		[](const char *p, const char *e, vector<string> &v) { return parse_strings(p, e, v); });
+}
+
+/*
+ * Read integers stored as they are in memory (native byte order, 32 bits
+ * each).
+ *
+ * @return false if the file size is not a multiple of the integer size.
+ */
+inline bool
+read_binary_ints(const input_file &in, vector<int> &values)
+{
+	if (in.size() % sizeof(int) != 0)
+		return false;
+
+	values.resize(in.size() / sizeof(int));
+	if (!values.empty())
+		memcpy(values.data(), in.begin(), in.size());
+	return true;
+}
+
+#endif // INPUT_H_
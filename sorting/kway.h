@@ -0,0 +1,230 @@
+#if !defined(KWAY_H_)
+#define KWAY_H_
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include "parallel.h"
+#include "simd.h"
+#include "histogram.h"
+
+using namespace std;
+
+/*
+ * k-way partition (counting sort by category).
+ *
+ * The Dutch national flag (3 values) and the black and white partition
+ * (2 values) are the k = 3 and k = 2 cases of a general problem: given a
+ * category in [0, k) for every element, put the elements of category 0
+ * first, then those of category 1, and so on. This is done in three steps:
+ * - classify: the category of every element is computed once, without
+ *   branches, and cached in a byte array; the elements are not compared
+ *   again.
+ * - count: a histogram of the categories (vectorized for k <= 8, see
+ *   simd_histogram()) and an exclusive scan give the bucket bounds.
+ * - scatter: every element is moved to the next free slot of its bucket
+ *   in an auxiliary vector, then moved back. Both loops are free of
+ *   branches; following the cycles of the permutation in place (as the
+ *   American flag sort step of msd_radix_sort_v2 in radix.h) mispredicts
+ *   on every misplaced element, and was slower even for k = 3.
+ *
+ * The partition is stable. Large inputs are split between threads: every
+ * thread classifies and counts its own chunk, and scatters it at offsets
+ * given by the scan over all the threads' histograms (see histogram.h).
+ */
+
+constexpr size_t kway_max = 256;        // categories fit in a byte
+constexpr size_t kway_small = 4096;     // partitions this small reuse a per-thread buffer
+
+/*
+ * Working space of a k-way partition.
+ */
+template<typename T>
+struct kway_buffer
+{
+	size_t              size = 0;
+	unique_ptr<uint8_t[]> cat;  // cat[i] is the category of element i
+	unique_ptr<T[]>     aux;    // the elements, in bucket order
+	vector<size_t>      count;  // count[t * k + c]: category c in chunk t
+
+	/*
+	 * Room for n elements. The arrays are default-initialized: every
+	 * slot is written before it is read, so numbers are not zeroed.
+	 */
+	void reserve(size_t n)
+	{
+		if (size < n) {
+			cat.reset(new uint8_t[n]);
+			aux.reset(new T[n]);
+			size = n;
+		}
+	}
+};
+
+/*
+ * Compute the category of every element of a[0, n) and add the number of
+ * elements in every category to count[0, k).
+ */
+template<typename T, typename F>
+void
+kway_classify(const T *a, size_t n, size_t k, F category, uint8_t *cat, size_t *count)
+{
+	for (size_t i = 0; i < n; ++i)
+		cat[i] = static_cast<uint8_t>(category(a[i]));
+
+	if (simd_histogram(cat, n, k, count))
+		return;
+
+	/*
+	 * Four histograms, so that a run of one category does not make every
+	 * increment wait for the previous one.
+	 */
+	size_t c4[4][kway_max];
+	size_t i = 0;
+
+	for (size_t j = 0; j < 4; ++j)
+		fill(c4[j], c4[j] + k, 0);
+
+	for (; i + 4 <= n; i += 4) {
+		c4[0][cat[i]]++;
+		c4[1][cat[i + 1]]++;
+		c4[2][cat[i + 2]]++;
+		c4[3][cat[i + 3]]++;
+	}
+
+	for (; i < n; ++i)
+		c4[0][cat[i]]++;
+
+	for (size_t c = 0; c < k; ++c)
+		count[c] += c4[0][c] + c4[1][c] + c4[2][c] + c4[3][c];
+}
+
+/*
+ * k-way partition of a[0, n) with nthreads threads, in the given buffer.
+ */
+template<typename T, typename F>
+void
+kway_partition(T *a, size_t n, size_t k, F category, size_t *bounds, size_t nthreads, kway_buffer<T> &buf)
+{
+	buf.reserve(n);
+
+	parallel_histogram(n, k, nthreads, [&](size_t lo, size_t hi, size_t *hist) {
+		kway_classify(a + lo, hi - lo, k, category, &buf.cat[lo], hist);
+	}, buf.count);
+
+	scatter_offsets(buf.count.data(), nthreads, k, bounds);
+
+	run_parallel(nthreads, [&](size_t t) {
+		size_t lo, hi;
+		histogram_chunk(n, nthreads, t, lo, hi);
+		size_t *next = &buf.count[t * k];
+		for (size_t i = lo; i < hi; ++i)
+			buf.aux[next[buf.cat[i]]++] = std::move(a[i]);
+	});
+
+	run_parallel(nthreads, [&](size_t t) {
+		size_t lo, hi;
+		histogram_chunk(n, nthreads, t, lo, hi);
+		move(buf.aux.get() + lo, buf.aux.get() + hi, a + lo);
+	});
+}
+
+/*
+ * Partition [first, last) into k buckets by category.
+ *
+ * @param [inout] first    - the first element.
+ * @param [inout] last     - one past the last element.
+ * @param [in]    k        - the number of categories (1 - 256).
+ * @param [in]    category - returns the category of an element, in [0, k).
+ *                           It is called once per element, before any
+ *                           element moves.
+ * @param [out]   bounds   - k + 1 offsets from first; the elements of
+ *                           category c are [bounds[c], bounds[c + 1]).
+ * @param [in]    nthreads - the number of threads (0: one per core); the
+ *                           input is split only if it is large enough.
+ */
+template<typename T, typename F>
+void
+kway_partition(T *first, T *last, size_t k, F category, size_t *bounds, size_t nthreads = 1)
+{
+	size_t n = last - first;
+
+	if (n == 0) {
+		fill(bounds, bounds + k + 1, 0);
+		return;
+	}
+
+	nthreads = histogram_threads(n, nthreads);
+
+	/*
+	 * Quick sort partitions ever smaller ranges: those do not allocate,
+	 * and the buffer kept per thread stays small.
+	 */
+	if ((n <= kway_small) && (nthreads == 1)) {
+		thread_local kway_buffer<T> buf;
+		kway_partition(first, n, k, category, bounds, 1, buf);
+	} else {
+		kway_buffer<T> buf;
+		kway_partition(first, n, k, category, bounds, nthreads, buf);
+	}
+}
+
+/*
+ * Partition all the elements into k buckets by category.
+ *
+ * @return the k + 1 bucket bounds (see above).
+ */
+template<typename T, typename F>
+vector<size_t>
+kway_partition(vector<T> &elements, size_t k, F category, size_t nthreads = 1)
+{
+	vector<size_t> bounds(k + 1);
+
+	kway_partition(elements.data(), elements.data() + elements.size(), k, category, bounds.data(), nthreads);
+	return bounds;
+}
+
+/*
+ * -1, 0 or 1 as a is less than, equal to or greater than b. Strings are
+ * compared once, not twice.
+ */
+template<typename T>
+inline int
+kway_sign(const T &a, const T &b)
+{
+	return (b < a) - (a < b);
+}
+
+inline int
+kway_sign(const string &a, const string &b)
+{
+	int r = a.compare(b);
+	return (r > 0) - (r < 0);
+}
+
+/*
+ * 3-way partition of elements[lo, hi] around elements[lo], as partition()
+ * in sort.h: the categories are less than, equal to and greater than the
+ * pivot. The pivot is only read while classifying, so it is not copied.
+ * Unlike partition(), the order of equal elements is kept.
+ *
+ * @param [out]   p1        - the starting index of the elements equal to the pivot.
+ * @param [out]   p2        - the ending index of the elements equal to the pivot.
+ */
+template<typename T>
+void
+kway_partition3(vector<T> &elements, size_t lo, size_t hi, size_t &p1, size_t &p2)
+{
+	const T &pivot = elements[lo];
+	size_t bounds[4];
+
+	kway_partition(elements.data() + lo, elements.data() + hi + 1, 3,
+		[&pivot](const T &v) { return 1 + kway_sign(v, pivot); }, bounds);
+
+	p1 = lo + bounds[1];
+	p2 = lo + bounds[2] - 1;
+}
+
+#endif // KWAY_H_
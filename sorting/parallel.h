@@ -0,0 +1,882 @@
+#if !defined(PARALLEL_H_)
+#define PARALLEL_H_
+
+#include <vector>
+#include <thread>
+#include <utility>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+using namespace std;
+
+/*
+ * Number of threads to use when none is specified.
+ */
+inline size_t
+default_threads()
+{
+	unsigned n = thread::hardware_concurrency();
+	return (n != 0) ? n : 1;
+}
+
+/*
+ * Run func(0), ..., func(nthreads - 1), each on its own thread, and wait
+ * for all of them to finish. func(0) runs on the calling thread.
+ */
+template<typename F>
+void
+run_parallel(size_t nthreads, F func)
+{
+	vector<thread> workers;
+
+	workers.reserve(nthreads - 1);
+	for (size_t t = 1; t < nthreads; ++t)
+		workers.emplace_back(func, t);
+
+	func(0);
+
+	for (auto &w : workers)
+		w.join();
+}
+
+/*
+ * Tournament (loser) tree over k sorted runs. The root holds the run with
+ * the smallest head element; every internal node holds the loser of the
+ * match played there. Taking the smallest element and refilling from the
+ * same run replays the matches on one leaf-to-root path: log2(k)
+ * comparisons, against k - 1 for a linear scan of the run heads.
+ *
+ * Equal elements are taken from the run with the lower index first, so
+ * merging the runs of a stable sort keeps it stable.
+ */
+template<typename T>
+class loser_tree
+{
+private:
+	struct run
+	{
+		T   *cur;   // next element of the run
+		T   *end;   // one past the last element of the run
+	};
+
+	size_t          _k;     // number of leaves, a power of 2
+	vector<run>     _runs;  // _runs[i] is leaf i; padding leaves are empty
+	vector<size_t>  _tree;  // _tree[0] is the winner, _tree[1, k) the losers
+
+	/*
+	 * Does run a win against run b? An exhausted run never wins.
+	 */
+	bool beats(size_t a, size_t b) const
+	{
+		if (_runs[a].cur == _runs[a].end)
+			return false;
+		if (_runs[b].cur == _runs[b].end)
+			return true;
+		if (*_runs[a].cur < *_runs[b].cur)
+			return true;
+		if (*_runs[b].cur < *_runs[a].cur)
+			return false;
+		return a < b;
+	}
+
+	/*
+	 * Play the matches below node; returns the winner.
+	 */
+	size_t play(size_t node)
+	{
+		if (node >= _k)
+			return node - _k;
+
+		size_t l = play(2 * node);
+		size_t r = play(2 * node + 1);
+
+		if (beats(l, r)) {
+			_tree[node] = r;
+			return l;
+		}
+		_tree[node] = l;
+		return r;
+	}
+
+public:
+	explicit loser_tree(size_t nruns) : _k(1)
+	{
+		while (_k < nruns)
+			_k *= 2;
+		_runs.resize(_k, { nullptr, nullptr });
+		_tree.resize(_k, 0);
+	}
+
+	/*
+	 * Set the range [begin, end) of run i. Call build() once all the runs are set.
+	 */
+	void set_run(size_t i, T *begin, T *end)
+	{
+		_runs[i] = { begin, end };
+	}
+
+	void build()
+	{
+		_tree[0] = play(1);
+	}
+
+	bool empty() const
+	{
+		const run &r = _runs[_tree[0]];
+		return r.cur == r.end;
+	}
+
+	/*
+	 * The smallest element.
+	 */
+	T & top()
+	{
+		return *_runs[_tree[0]].cur;
+	}
+
+	/*
+	 * The run holding the smallest element.
+	 */
+	size_t winner() const
+	{
+		return _tree[0];
+	}
+
+	/*
+	 * Number of elements left in run i.
+	 */
+	size_t left(size_t i) const
+	{
+		return _runs[i].end - _runs[i].cur;
+	}
+
+	/*
+	 * Remove the smallest element.
+	 */
+	void pop()
+	{
+		_runs[_tree[0]].cur++;
+		replay();
+	}
+
+	/*
+	 * Remove the smallest element and continue its run with the elements
+	 * in [begin, end), e.g. the next block of a run read from a file.
+	 */
+	void refill(T *begin, T *end)
+	{
+		_runs[_tree[0]] = { begin, end };
+		replay();
+	}
+
+private:
+	/*
+	 * Replay the matches on the path of the winner, whose head changed.
+	 */
+	void replay()
+	{
+		size_t w = _tree[0];
+
+		for (size_t node = (w + _k) / 2; node > 0; node /= 2) {
+			if (beats(_tree[node], w))
+				swap(_tree[node], w);
+		}
+		_tree[0] = w;
+	}
+};
+
+/*
+ * Multi-sequence selection: find how many elements of every sorted run
+ * are among the r smallest elements of all the runs. Ties are broken by
+ * run index (as in loser_tree), so the split is unique and a stable merge
+ * of the pieces on either side gives the stable merge of the whole.
+ *
+ * Every step takes the middle of the largest undecided range as the pivot,
+ * ranks it in every run by binary search and discards the side of every
+ * range that cannot hold the split.
+ *
+ * @param [in]  runs  - the sorted runs, as [begin, end) pairs.
+ * @param [in]  r     - the rank to split at.
+ * @param [out] split - split[i] is the number of elements taken from runs[i].
+ */
+template<typename T>
+void
+multiway_split(const vector<pair<T *, T *>> &runs, size_t r, vector<size_t> &split)
+{
+	size_t k = runs.size();
+	vector<size_t> lo(k, 0);
+	vector<size_t> hi(k);
+	vector<size_t> pos(k);
+
+	for (size_t i = 0; i < k; ++i)
+		hi[i] = runs[i].second - runs[i].first;
+
+	while (true) {
+		size_t p = 0;
+		for (size_t i = 1; i < k; ++i) {
+			if ((hi[i] - lo[i]) > (hi[p] - lo[p]))
+				p = i;
+		}
+
+		if (lo[p] == hi[p])
+			break;
+
+		size_t mid = lo[p] + (hi[p] - lo[p]) / 2;
+		const T &pivot = runs[p].first[mid];
+
+		/*
+		 * pos[i] is the number of elements of run i that come before the
+		 * pivot: equal elements of an earlier run come before it, those of
+		 * a later run after it.
+		 */
+		size_t rank = 0;
+		for (size_t i = 0; i < k; ++i) {
+			T *b = runs[i].first + lo[i];
+			T *e = runs[i].first + hi[i];
+			if (i < p)
+				pos[i] = upper_bound(b, e, pivot) - runs[i].first;
+			else if (i > p)
+				pos[i] = lower_bound(b, e, pivot) - runs[i].first;
+			else
+				pos[i] = mid;
+			rank += pos[i];
+		}
+
+		if (rank < r) {
+			// the pivot and everything before it are in.
+			lo = pos;
+			lo[p] = mid + 1;
+		} else {
+			// the pivot and everything after it are out.
+			hi = pos;
+		}
+	}
+
+	split = lo;
+}
+
+/*
+ * Parallel merge sort.
+ *
+ * The elements are cut into one chunk per thread and every thread sorts
+ * its chunk (std::stable_sort). The sorted chunks are then merged in
+ * parallel: the output is cut into equal slices, multiway_split() finds
+ * the part of every chunk that lands in a slice, and every thread merges
+ * its slice with a loser tree. The elements are moved, not copied.
+ *
+ * The sort is stable.
+ *
+ * @param [inout] elements - the vector to sort.
+ * @param [in]    nthreads - the number of threads (0 - one per core).
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T>
+void
+parallel_merge_sort(vector<T> &elements, size_t nthreads = 0)
+{
+	constexpr size_t min_chunk = 4096;      // not worth a thread below this
+
+	size_t n = elements.size();
+
+	if (nthreads == 0)
+		nthreads = default_threads();
+	nthreads = min(nthreads, max<size_t>(n / min_chunk, 1));
+
+	if (nthreads == 1) {
+		stable_sort(elements.begin(), elements.end());
+		return;
+	}
+
+	vector<pair<T *, T *>> runs(nthreads);
+	for (size_t t = 0; t < nthreads; ++t)
+		runs[t] = { elements.data() + t * n / nthreads, elements.data() + (t + 1) * n / nthreads };
+
+	run_parallel(nthreads, [&runs](size_t t) {
+		stable_sort(runs[t].first, runs[t].second);
+	});
+
+	/*
+	 * splits[t] is where slice t starts in every chunk. All the splits are
+	 * found before any merge starts: the merges move elements out of the
+	 * chunks the binary searches read.
+	 */
+	vector<vector<size_t>> splits(nthreads + 1);
+
+	run_parallel(nthreads, [&](size_t t) {
+		multiway_split(runs, t * n / nthreads, splits[t]);
+	});
+
+	splits[nthreads].resize(nthreads);
+	for (size_t i = 0; i < nthreads; ++i)
+		splits[nthreads][i] = runs[i].second - runs[i].first;
+
+	vector<T> merged(n);
+
+	run_parallel(nthreads, [&](size_t t) {
+		loser_tree<T> tree(nthreads);
+		for (size_t i = 0; i < nthreads; ++i)
+			tree.set_run(i, runs[i].first + splits[t][i], runs[i].first + splits[t + 1][i]);
+		tree.build();
+
+		for (size_t j = t * n / nthreads; j < (t + 1) * n / nthreads; ++j) {
+			merged[j] = std::move(tree.top());
+			tree.pop();
+		}
+	});
+
+	elements.swap(merged);
+}
+
+/*
+ * Splitters of one sample sort step.
+ *
+ * The splitters are picked from a random sample of the input and stored
+ * as an implicit binary search tree (tree[1] is the root, the children of
+ * tree[j] are tree[2j] and tree[2j + 1]). Finding the bucket of an element
+ * then takes log2(k) steps of j = 2j + (tree[j] < x), with no branch to
+ * mispredict, and several elements are classified side by side so that
+ * their steps overlap.
+ *
+ * With m distinct splitters s[0] < ... < s[m - 1], bucket 2b holds the
+ * elements in (s[b - 1], s[b]) and bucket 2b + 1 the elements equal to
+ * s[b]. The equality buckets need no further sorting, so inputs with many
+ * duplicates finish early.
+ */
+template<typename T>
+class sample_classifier
+{
+private:
+	static constexpr size_t oversample = 8;     // sample elements per splitter
+
+	size_t      _k;         // number of leaves of the tree, a power of 2
+	unsigned    _levels;    // log2(_k)
+	size_t      _m;         // number of distinct splitters
+	vector<T>   _tree;      // the search tree, _tree[1, k)
+	vector<T>   _sorted;    // the distinct splitters in order
+
+	void build(size_t j, const vector<T> &padded, size_t &i)
+	{
+		if (j >= _k)
+			return;
+		build(2 * j, padded, i);
+		_tree[j] = padded[i++];
+		build(2 * j + 1, padded, i);
+	}
+
+	size_t bucket(size_t leaf, const T &x) const
+	{
+		size_t b = min(leaf, _m);
+		return 2 * b + ((b < _m) && !(x < _sorted[b]));
+	}
+
+public:
+	/*
+	 * Pick up to k - 1 splitters for elements[0, n).
+	 */
+	sample_classifier(const T *elements, size_t n, size_t k)
+	{
+		uint64_t seed = n * 0x9e3779b97f4a7c15ULL + 1;
+		size_t nsample = min(n, oversample * k);
+		vector<T> sample;
+
+		sample.reserve(nsample);
+		for (size_t i = 0; i < nsample; ++i) {
+			// xorshift64
+			seed ^= seed << 13;
+			seed ^= seed >> 7;
+			seed ^= seed << 17;
+			sample.push_back(elements[seed % n]);
+		}
+		sort(sample.begin(), sample.end());
+
+		size_t step = max<size_t>(nsample / k, 1);
+		for (size_t i = step - 1; (i + 1 < nsample) && (_sorted.size() + 1 < k); i += step) {
+			if (_sorted.empty() || (_sorted.back() < sample[i]))
+				_sorted.push_back(sample[i]);
+		}
+		if (_sorted.empty())
+			_sorted.push_back(sample[nsample / 2]);
+
+		_m = _sorted.size();
+		for (_k = 2, _levels = 1; _k < _m + 1; _k *= 2, _levels++)
+			;
+
+		vector<T> padded(_sorted);
+		padded.resize(_k - 1, _sorted.back());
+
+		size_t i = 0;
+		_tree.resize(_k);
+		build(1, padded, i);
+	}
+
+	size_t buckets() const
+	{
+		return 2 * _m + 1;
+	}
+
+	static bool equal_bucket(size_t b)
+	{
+		return (b & 1) != 0;
+	}
+
+	/*
+	 * The bucket of x.
+	 */
+	size_t classify(const T &x) const
+	{
+		size_t j = 1;
+		for (unsigned l = 0; l < _levels; ++l)
+			j = 2 * j + (_tree[j] < x);
+		return bucket(j - _k, x);
+	}
+
+	/*
+	 * Classify elements[0, n): func(i, b) is called with the bucket b of
+	 * every element i, in order. The bucket of element i is found before
+	 * func(i, b) is called, and elements after i are not read before it
+	 * returns, so func may move elements[0, i] around.
+	 */
+	template<typename F>
+	void classify(const T *elements, size_t n, F func) const
+	{
+		constexpr size_t U = 4;     // elements classified together
+		size_t i = 0;
+
+		for (; i + U <= n; i += U) {
+			size_t j[U];
+			for (size_t u = 0; u < U; ++u)
+				j[u] = 1;
+			for (unsigned l = 0; l < _levels; ++l) {
+				for (size_t u = 0; u < U; ++u)
+					j[u] = 2 * j[u] + (_tree[j[u]] < elements[i + u]);
+			}
+			for (size_t u = 0; u < U; ++u)
+				func(i + u, bucket(j[u] - _k, elements[i + u]));
+		}
+
+		for (; i < n; ++i)
+			func(i, classify(elements[i]));
+	}
+};
+
+constexpr size_t sample_sort_base = 2048;       // std::sort below this
+constexpr size_t sample_sort_parallel = 65536;  // one thread below this
+constexpr size_t sample_sort_leaves = 256;      // max buckets per step, excluding equality buckets
+constexpr unsigned sample_sort_depth = 12;      // std::sort beyond this many steps
+
+/*
+ * Elements per block of the in-place distribution: 2 KB worth of them.
+ */
+template<typename T>
+constexpr size_t sample_sort_block = max<size_t>(2048 / sizeof(T), 1);
+
+/*
+ * Number of leaves for a sample sort step over n elements: enough for
+ * the buckets to reach the base case size in one step, if possible.
+ */
+inline size_t
+sample_sort_leaves_for(size_t n)
+{
+	size_t k = 2;
+	while ((k < sample_sort_leaves) && (k * sample_sort_base < n))
+		k *= 2;
+	return k;
+}
+
+/*
+ * Working space of one thread for the in-place distribution. It holds a
+ * partial block per bucket and a few more blocks; its size depends on the
+ * number of buckets, not on the number of elements.
+ */
+template<typename T>
+struct sample_sort_buffers
+{
+	vector<T>       block;      // block[b * B, b * B + fill[b]): the partial block of bucket b
+	vector<size_t>  fill;       // elements in the partial block of every bucket
+	vector<size_t>  count;      // elements of every bucket in the thread's stripe
+	vector<T>       swap;       // the two blocks of the block permutation
+	vector<T>       overflow;   // a block that would end past the end of the elements
+
+	/*
+	 * Empty partial blocks for nb buckets.
+	 */
+	void reset(size_t nb)
+	{
+		constexpr size_t B = sample_sort_block<T>;
+
+		if (block.size() < nb * B)
+			block.resize(nb * B);
+		if (swap.empty()) {
+			swap.resize(2 * B);
+			overflow.resize(B);
+		}
+		fill.assign(nb, 0);
+		count.assign(nb, 0);
+	}
+};
+
+/*
+ * Classify a[lo, hi) into the partial blocks of buf. A block that fills
+ * up is written back to the front of the range, over elements that have
+ * already been read.
+ *
+ * @return the end of the full blocks: a[lo, end) is made of full blocks,
+ *         each of a single bucket, and a[end, hi) is free.
+ */
+template<typename T>
+static size_t
+sample_sort_classify(const sample_classifier<T> &cls, T *a, size_t lo, size_t hi, sample_sort_buffers<T> &buf)
+{
+	constexpr size_t B = sample_sort_block<T>;
+	T *block = buf.block.data();
+	size_t *fill = buf.fill.data();
+	size_t *count = buf.count.data();
+	size_t end = lo;
+
+	cls.classify(a + lo, hi - lo, [&](size_t i, size_t b) {
+		T *p = block + b * B;
+		p[fill[b]++] = std::move(a[lo + i]);
+		if (fill[b] == B) {
+			move(p, p + B, a + end);
+			end += B;
+			count[b] += B;
+			fill[b] = 0;
+		}
+	});
+
+	for (size_t b = 0; b < buf.fill.size(); ++b)
+		count[b] += fill[b];
+
+	return end;
+}
+
+/*
+ * One in-place sample sort step (IPS4o): distribute a[0, n) by bucket
+ * with nthreads threads, using bufs[0, nthreads).
+ *
+ * - classify: every thread classifies its stripe of blocks into its
+ *   partial blocks, and writes every full block back to the front of the
+ *   stripe.
+ * - the bucket starts are rounded up to whole blocks, and the full blocks
+ *   that fall in the blocks of a bucket are moved to the front of them.
+ * - block permutation: every full block is swapped into the next block of
+ *   its bucket. Every bucket has a write pointer w (the blocks before it
+ *   are in place) and a read pointer r (the blocks in [w, r) are still to
+ *   be moved), guarded by a lock.
+ * - cleanup: the elements of a bucket are in its blocks, in the partial
+ *   blocks of the threads, and, if its last block goes past its end, in
+ *   the first elements of the next bucket. They are moved to the slots at
+ *   either end of the bucket that the blocks leave free.
+ *
+ * Apart from the buffers, the elements need no extra space.
+ *
+ * @param [out]   start    - nb + 1 entries; bucket b is a[start[b], start[b + 1]).
+ */
+template<typename T>
+static void
+sample_sort_distribute(const sample_classifier<T> &cls, T *a, size_t n, size_t nthreads,
+	sample_sort_buffers<T> *bufs, vector<size_t> &start)
+{
+	constexpr size_t B = sample_sort_block<T>;
+	size_t nb = cls.buckets();
+	size_t stripe = ((n + nthreads - 1) / nthreads + B - 1) / B * B;
+	vector<size_t> full(nthreads);
+
+	run_parallel(nthreads, [&](size_t t) {
+		size_t lo = min(n, t * stripe);
+		size_t hi = min(n, lo + stripe);
+		bufs[t].reset(nb);
+		full[t] = sample_sort_classify(cls, a, lo, hi, bufs[t]);
+	});
+
+	start.assign(nb + 1, 0);
+	for (size_t t = 0; t < nthreads; ++t) {
+		for (size_t b = 0; b < nb; ++b)
+			start[b + 1] += bufs[t].count[b];
+	}
+	for (size_t b = 0; b < nb; ++b)
+		start[b + 1] += start[b];
+
+	/*
+	 * The blocks of bucket b are [d[b], d[b + 1]). Only those that end
+	 * within the elements can hold a full block from the classification.
+	 */
+	vector<size_t> d(nb + 1);
+	for (size_t b = 0; b <= nb; ++b)
+		d[b] = (start[b] + B - 1) / B * B;
+
+	size_t last = n / B * B;
+	vector<size_t> w(nb);
+	vector<size_t> r(nb);
+	atomic<size_t> next(0);
+
+	auto filled = [&](size_t s) {
+		return s < full[s / stripe];
+	};
+
+	run_parallel(nthreads, [&](size_t) {
+		for (size_t b = next++; b < nb; b = next++) {
+			size_t lo = d[b];
+			size_t hi = max(lo, min(d[b + 1], last));
+
+			for (;;) {
+				while ((lo < hi) && filled(lo))
+					lo += B;
+				while ((lo < hi) && !filled(hi - B))
+					hi -= B;
+				if (lo >= hi)
+					break;
+				move(a + hi - B, a + hi, a + lo);
+				lo += B;
+				hi -= B;
+			}
+
+			w[b] = d[b];
+			r[b] = lo;
+		}
+	});
+
+	/*
+	 * Every thread starts at its own bucket, and takes blocks from every
+	 * bucket in turn until none is left. A block read from a bucket is
+	 * swapped into the next block of its own bucket, and the block found
+	 * there moves on in the same way, until a block lands on a free slot.
+	 * The block that would end past n (at most one) goes to the overflow
+	 * buffer instead.
+	 */
+	vector<mutex> locks(nb);
+	T *overflow = bufs[0].overflow.data();
+
+	run_parallel(nthreads, [&](size_t t) {
+		T *cur = bufs[t].swap.data();
+		T *other = cur + B;
+
+		for (size_t i = 0; i < nb; ++i) {
+			size_t b = (t * nb / nthreads + i) % nb;
+
+			for (;;) {
+				{
+					lock_guard<mutex> guard(locks[b]);
+					if (w[b] >= r[b])
+						break;
+					r[b] -= B;
+					move(a + r[b], a + r[b] + B, cur);
+				}
+
+				size_t dest = cls.classify(cur[0]);
+
+				for (;;) {
+					size_t s;
+					bool empty;
+					{
+						lock_guard<mutex> guard(locks[dest]);
+						s = w[dest];
+						w[dest] += B;
+						empty = (s >= r[dest]);
+					}
+
+					if (empty) {
+						move(cur, cur + B, (s + B <= n) ? a + s : overflow);
+						break;
+					}
+
+					size_t c = cls.classify(a[s]);
+					if (c == dest)
+						continue;
+
+					move(a + s, a + s + B, other);
+					move(cur, cur + B, a + s);
+					swap(cur, other);
+					dest = c;
+				}
+			}
+		}
+	});
+
+	/*
+	 * The blocks of bucket b are now [d[b], w[b]). Without any, the
+	 * bucket may start in the last partial block; w[b] is moved back to
+	 * its end so that w[b] > start[b + 1] only when the blocks do go past
+	 * the end of the bucket.
+	 */
+	for (size_t b = 0; b < nb; ++b) {
+		if (w[b] == d[b])
+			w[b] = min(w[b], start[b + 1]);
+	}
+
+	/*
+	 * The elements of bucket b that its blocks put past start[b + 1],
+	 * i.e. in the first slots of bucket b + 1.
+	 */
+	auto spill = [&](size_t b) -> T * {
+		if (w[b] > n)
+			return overflow + (start[b + 1] - (w[b] - B));
+		return a + start[b + 1];
+	};
+
+	/*
+	 * The buckets are cleaned up by ranges, one per thread, in order: a
+	 * bucket moves its spilled elements out of the buckets after it
+	 * before those fill their free slots. A spill that reaches into the
+	 * next range is set aside first.
+	 */
+	vector<vector<T>> saved(nb);
+
+	for (size_t t = 0; t + 1 < nthreads; ++t) {
+		size_t end = (t + 1) * nb / nthreads;
+		for (size_t b = t * nb / nthreads; b < end; ++b) {
+			if (w[b] > start[end]) {
+				T *p = spill(b);
+				saved[b].assign(make_move_iterator(p), make_move_iterator(p + w[b] - start[b + 1]));
+			}
+		}
+	}
+
+	run_parallel(nthreads, [&](size_t t) {
+		size_t first = t * nb / nthreads;
+		size_t end = (t + 1) * nb / nthreads;
+
+		for (size_t b = first; b < end; ++b) {
+			size_t lo = start[b];
+			size_t hi = start[b + 1];
+			size_t head = min(d[b], hi);
+			size_t tail = w[b];
+			size_t out = lo;
+
+			auto put = [&](T &x) {
+				if (out == head)
+					out = tail;
+				a[out++] = std::move(x);
+			};
+
+			if (w[b] > n) {
+				T *p = overflow;
+				move(p, p + (hi - (w[b] - B)), a + w[b] - B);
+			}
+
+			if (w[b] > hi) {
+				T *p = saved[b].empty() ? spill(b) : saved[b].data();
+				for (size_t i = 0; i < w[b] - hi; ++i)
+					put(p[i]);
+			}
+
+			for (size_t u = 0; u < nthreads; ++u) {
+				T *p = bufs[u].block.data() + b * B;
+				for (size_t i = 0; i < bufs[u].fill[b]; ++i)
+					put(p[i]);
+			}
+		}
+	});
+}
+
+/*
+ * Sequential sample sort of a[0, n), in place.
+ */
+template<typename T>
+static void
+sample_sort_sequential(T *a, size_t n, unsigned depth, sample_sort_buffers<T> &buf)
+{
+	if ((n <= sample_sort_base) || (depth >= sample_sort_depth)) {
+		sort(a, a + n);
+		return;
+	}
+
+	sample_classifier<T> cls(a, n, sample_sort_leaves_for(n));
+	vector<size_t> start;
+
+	sample_sort_distribute(cls, a, n, 1, &buf, start);
+
+	for (size_t b = 0; b + 1 < start.size(); ++b) {
+		size_t size = start[b + 1] - start[b];
+		if ((size > 1) && !cls.equal_bucket(b))
+			sample_sort_sequential(a + start[b], size, depth + 1, buf);
+	}
+}
+
+/*
+ * Parallel sample sort step: all the threads distribute a[0, n). The
+ * buckets are then handed out to the threads, largest first; a bucket too
+ * big for one thread is sorted by another parallel step.
+ */
+template<typename T>
+static void
+sample_sort_parallel_step(T *a, size_t n, size_t nthreads, sample_sort_buffers<T> *bufs)
+{
+	if ((nthreads == 1) || (n < sample_sort_parallel)) {
+		sample_sort_sequential(a, n, 0, bufs[0]);
+		return;
+	}
+
+	sample_classifier<T> cls(a, n, sample_sort_leaves);
+	vector<size_t> start;
+
+	sample_sort_distribute(cls, a, n, nthreads, bufs, start);
+
+	size_t nb = cls.buckets();
+	vector<size_t> tasks;
+	vector<size_t> big;
+	for (size_t b = 0; b < nb; ++b) {
+		size_t size = start[b + 1] - start[b];
+		if ((size <= 1) || cls.equal_bucket(b))
+			continue;
+		if (size > n / nthreads)
+			big.push_back(b);
+		else
+			tasks.push_back(b);
+	}
+
+	sort(tasks.begin(), tasks.end(), [&start](size_t a, size_t b) {
+		return (start[a + 1] - start[a]) > (start[b + 1] - start[b]);
+	});
+
+	atomic<size_t> next_task(0);
+
+	run_parallel(nthreads, [&](size_t t) {
+		for (size_t i = next_task++; i < tasks.size(); i = next_task++) {
+			size_t b = tasks[i];
+			sample_sort_sequential(a + start[b], start[b + 1] - start[b], 1, bufs[t]);
+		}
+	});
+
+	for (auto b : big)
+		sample_sort_parallel_step(a + start[b], start[b + 1] - start[b], nthreads, bufs);
+}
+
+/*
+ * Parallel in-place super scalar sample sort (IPS4o).
+ *
+ * A generalization of quick sort to up to 256 pivots (splitters) picked
+ * from a random sample, so that sorted, reverse sorted and duplicate
+ * heavy inputs do not degrade. Every step classifies the elements with a
+ * branch free search tree and distributes them by bucket in place, a
+ * block at a time (see sample_sort_distribute()). The first steps run on
+ * all threads; the buckets are then sorted as independent tasks.
+ *
+ * Besides the elements, every thread uses about 2 KB per bucket, so the
+ * sort fits arrays that take most of the memory.
+ *
+ * @param [inout] elements - the vector to sort.
+ * @param [in]    nthreads - the number of threads (0 - one per core).
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T>
+void
+parallel_sample_sort(vector<T> &elements, size_t nthreads = 0)
+{
+	size_t n = elements.size();
+	if (n <= 1)
+		return;
+
+	if (nthreads == 0)
+		nthreads = default_threads();
+
+	vector<sample_sort_buffers<T>> bufs(nthreads);
+
+	sample_sort_parallel_step(elements.data(), n, nthreads, bufs.data());
+}
+
+#endif // PARALLEL_H_
@@ -0,0 +1,263 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include "partition.h"
+#include "kway.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+using namespace std;
+
+/*
+ * Branch miss counter for the calling thread. Reads as -1 where hardware
+ * counters are not available (not Linux, no PMU in a VM, or
+ * perf_event_paranoid too strict).
+ */
+class branch_misses
+{
+private:
+	int _fd;
+
+public:
+	branch_misses() : _fd(-1)
+	{
+#if defined(__linux__)
+		struct perf_event_attr attr;
+
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+
+		_fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+	}
+
+	~branch_misses()
+	{
+#if defined(__linux__)
+		if (_fd >= 0)
+			close(_fd);
+#endif
+	}
+
+	void start()
+	{
+#if defined(__linux__)
+		if (_fd >= 0) {
+			ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+			ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	int64_t stop()
+	{
+		int64_t count = -1;
+#if defined(__linux__)
+		if (_fd >= 0) {
+			ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+			if (read(_fd, &count, sizeof(count)) != sizeof(count))
+				count = -1;
+		}
+#endif
+		return count;
+	}
+};
+
+/*
+ * The plain partition of sort.cpp (without the statistics): one branch
+ * per comparison.
+ */
+template<typename T>
+static size_t
+branchy_partition(vector<T> &elements, size_t lo, size_t hi)
+{
+	size_t i = lo + 1;
+	size_t j = hi;
+
+	while (i <= j) {
+		if (elements[i] < elements[lo]) {
+			i++;
+		} else if (elements[j] > elements[lo]) {
+			j--;
+		} else {
+			swap(elements[i], elements[j]);
+			i++;
+			j--;
+		}
+	}
+
+	if (lo != j)
+		swap(elements[lo], elements[j]);
+
+	return j;
+}
+
+/*
+ * The 3-way partition of sort.cpp (Dijkstra, without the statistics): one
+ * or two branches per element.
+ *
+ * @return the index of the first element equal to the pivot.
+ */
+template<typename T>
+static size_t
+dutch_partition(vector<T> &elements, size_t lo, size_t hi)
+{
+	size_t i = lo + 1;
+	size_t p1 = lo;
+	size_t p2 = hi;
+
+	while (i <= p2) {
+		if (elements[i] < elements[p1]) {
+			swap(elements[i++], elements[p1++]);
+		} else if (elements[i] == elements[p1]) {
+			i++;
+		} else {
+			swap(elements[i], elements[p2--]);
+		}
+	}
+
+	return p1;
+}
+
+/*
+ * The k-way partition of kway.h with k = 3 around elements[lo], on
+ * nthreads threads.
+ *
+ * @return the index of the first element equal to the pivot.
+ */
+template<typename T>
+static size_t
+kway3_partition(vector<T> &elements, size_t lo, size_t hi, size_t nthreads)
+{
+	const T pivot = elements[lo];
+	size_t bounds[4];
+
+	kway_partition(elements.data() + lo, elements.data() + hi + 1, 3,
+		[pivot](const T &v) { return 1 + kway_sign(v, pivot); }, bounds, nthreads);
+
+	return lo + bounds[1];
+}
+
+/*
+ * Partition fresh copies of input reps times and print the average time
+ * and branch misses per element.
+ */
+template<typename F>
+static void
+measure(const char *name, const vector<int32_t> &input, int reps, F func)
+{
+	vector<int32_t> elements;
+	branch_misses counter;
+	double usec = 0;
+	int64_t misses = 0;
+	size_t p = 0;
+
+	for (int r = 0; r < reps; ++r) {
+		elements = input;
+
+		counter.start();
+		chrono::time_point<chrono::high_resolution_clock> start = chrono::high_resolution_clock::now();
+		p = func(elements, 0, elements.size() - 1);
+		chrono::time_point<chrono::high_resolution_clock> stop = chrono::high_resolution_clock::now();
+		int64_t m = counter.stop();
+
+		usec += chrono::duration_cast<chrono::microseconds>(stop - start).count();
+		misses = ((m < 0) || (misses < 0)) ? -1 : misses + m;
+	}
+
+	double n = static_cast<double>(input.size()) * reps;
+
+	cout << setw(10) << name << setw(12) << input.size() << setw(12) << p
+		<< setw(12) << fixed << setprecision(3) << (usec * 1000 / n);
+	if (misses < 0)
+		cout << setw(16) << "n/a" << endl;
+	else
+		cout << setw(16) << fixed << setprecision(4) << (misses / n) << endl;
+}
+
+static int
+usage(const char *progname)
+{
+	cerr << progname << " [-n <count>] [-reps <count>] [-range <max>] [-seed <seed>] [-threads <n>]" << endl
+		<< "    -n <count>      Number of 32-bit keys (default 10000000)." << endl
+		<< "    -reps <count>   Repetitions per kernel (default 5)." << endl
+		<< "    -range <max>    Keys are drawn from [0, max] (default 2^31 - 1)." << endl
+		<< "    -seed <seed>    Random seed (default 1)." << endl
+		<< "    -threads <n>    Threads for the parallel k-way partition (default one per core)." << endl;
+	return 1;
+}
+
+int
+main(int argc, const char **argv)
+{
+	size_t n = 10000000;
+	int reps = 5;
+	int32_t range = INT32_MAX;
+	uint64_t seed = 1;
+	size_t nthreads = 0;
+
+	for (int i = 1; i < argc; ++i) {
+		if (argv[i + 1] == nullptr) {
+			cerr << "missing argument for " << argv[i] << endl;
+			return usage(argv[0]);
+		}
+
+		if (strcmp(argv[i], "-n") == 0) {
+			n = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-reps") == 0) {
+			reps = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-range") == 0) {
+			range = static_cast<int32_t>(strtol(argv[++i], nullptr, 10));
+		} else if (strcmp(argv[i], "-seed") == 0) {
+			seed = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-threads") == 0) {
+			nthreads = strtoull(argv[++i], nullptr, 10);
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	if ((n < 2) || (reps < 1) || (range < 0))
+		return usage(argv[0]);
+
+	mt19937_64 gen(seed);
+	uniform_int_distribution<int32_t> dist(0, range);
+	vector<int32_t> input(n);
+
+	for (auto &v : input)
+		v = dist(gen);
+
+	cout << setw(10) << "kernel" << setw(12) << "n" << setw(12) << "pivot at"
+		<< setw(12) << "ns/elem" << setw(16) << "misses/elem" << endl;
+
+	measure("branchy", input, reps, branchy_partition<int32_t>);
+	measure("block", input, reps, block_partition<int32_t>);
+
+	/*
+	 * 3-way kernels; "pivot at" is the first element equal to the pivot.
+	 */
+	measure("dutch", input, reps, dutch_partition<int32_t>);
+	measure("kway3", input, reps, [](vector<int32_t> &e, size_t lo, size_t hi) {
+		return kway3_partition(e, lo, hi, 1);
+	});
+	measure("kway3_par", input, reps, [nthreads](vector<int32_t> &e, size_t lo, size_t hi) {
+		return kway3_partition(e, lo, hi, nthreads);
+	});
+
+	return 0;
+}
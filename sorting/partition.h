@@ -0,0 +1,112 @@
+#if !defined(PARTITION_H_)
+#define PARTITION_H_
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+/*
+ * Block partition (BlockQuicksort, Edelkamp and Weiss).
+ *
+ * Same contract as partition() in sort.cpp: elements[lo] is the pivot; on
+ * return it is at its final position p, elements[lo, p) are not greater
+ * and elements(p, hi] are not less than the pivot.
+ *
+ * A plain partition branches on every comparison and, on random data,
+ * mispredicts about half of them. Here the comparisons are done a block
+ * at a time from both ends and only their results are kept: the offset of
+ * every element is written to a buffer and the buffer end advances by the
+ * comparison result, with no branch. The flagged elements (not less than
+ * the pivot on the left, not greater on the right) are then swapped in
+ * pairs. Like partition(), elements equal to the pivot are flagged on both
+ * sides, so duplicates split evenly.
+ *
+ * The last two blocks or less are partitioned the plain way.
+ *
+ * @param [inout] elements  - the input vector to partition.
+ * @param [in]    lo        - the starting index (the pivot).
+ * @param [in]    hi        - the ending index.
+ *
+ * @return the index of the pivot element.
+ */
+template<typename T>
+size_t
+block_partition(vector<T> &elements, size_t lo, size_t hi)
+{
+	constexpr size_t B = 128;       // block size; offsets fit in a byte
+
+	const T &pivot = elements[lo];
+	T *e = elements.data();
+
+	unsigned char offl[B];
+	unsigned char offr[B];
+	size_t numl = 0;
+	size_t numr = 0;
+	size_t startl = 0;
+	size_t startr = 0;
+
+	/*
+	 * [l, r] is the part not known to be on the right side yet. Everything
+	 * before l is not greater, everything after r not less than the pivot.
+	 */
+	size_t l = lo + 1;
+	size_t r = hi;
+
+	while (r + 1 - l > 2 * B) {
+		if (numl == 0) {
+			startl = 0;
+			for (size_t i = 0; i < B; ++i) {
+				offl[numl] = static_cast<unsigned char>(i);
+				numl += !(e[l + i] < pivot);
+			}
+		}
+
+		if (numr == 0) {
+			startr = 0;
+			for (size_t i = 0; i < B; ++i) {
+				offr[numr] = static_cast<unsigned char>(i);
+				numr += !(pivot < e[r - i]);
+			}
+		}
+
+		size_t num = min(numl, numr);
+		for (size_t j = 0; j < num; ++j)
+			swap(e[l + offl[startl + j]], e[r - offr[startr + j]]);
+
+		numl -= num;
+		numr -= num;
+		startl += num;
+		startr += num;
+
+		if (numl == 0)
+			l += B;
+		if (numr == 0)
+			r -= B;
+	}
+
+	/*
+	 * Plain partition of what is left: at most two blocks, plus the
+	 * flagged elements of a block that still has some.
+	 */
+	size_t i = l;
+	size_t j = r;
+
+	while (i <= j) {
+		if (e[i] < pivot) {
+			i++;
+		} else if (pivot < e[j]) {
+			j--;
+		} else {
+			swap(e[i], e[j]);
+			i++;
+			j--;
+		}
+	}
+
+	swap(e[lo], e[j]);
+
+	return j;
+}
+
+#endif // PARTITION_H_
@@ -14,9 +14,25 @@ do
 	echo "insertion: `sort -quiet -in $i -insertion`"
 	echo "merge recursive: `sort -quiet -in $i -merge_v1`"
 	echo "merge iterative: `sort -quiet -in $i -merge_v2`"
+	echo "merge parallel: `sort -quiet -in $i -merge_parallel`"
+	echo "powersort: `sort -quiet -in $i -merge_power`"
 	echo "quick normal partition: `sort -quiet -in $i -quick_v1`"
 	echo "quick 3-way partition: `sort -quiet -in $i -quick_v2`"
+	echo "intro: `sort -quiet -in $i -intro`"
+	echo "sample: `sort -quiet -in $i -sample`"
 	echo "heap: `sort -quiet -in $i -heap`"
+	echo "heap (4-ary, bottom-up): `sort -quiet -in $i -dary_heap -arity 4`"
+	echo "lsd radix (8-bit digits): `sort -quiet -in $i -lsd_radix_int -digit 8`"
+	echo "lsd radix (11-bit digits): `sort -quiet -in $i -lsd_radix_int -digit 11`"
+	echo "lsd radix (16-bit digits): `sort -quiet -in $i -lsd_radix_int -digit 16`"
+	echo "std::sort: `sort -quiet -in $i -std`"
+	echo "external (1 MB): `sort -quiet -in $i -external -mem 1`"
 done
 
 rm -f 100.txt 1000.txt 10000.txt 100000.txt 1000000.txt
+
+partbench -n 1000000
+histbench -n 1000000
+histbench -n 1000000 -one
+
+sortbench -n 1e3,1e4,1e5,1e6 -reps 5 > sortbench.csv
@@ -0,0 +1,284 @@
+#if !defined(PRNG_H_)
+#define PRNG_H_
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include "parallel.h"
+
+using namespace std;
+
+/*
+ * SplitMix64: spreads a seed over the state of the generators below, so
+ * that nearby seeds give unrelated streams.
+ */
+inline uint64_t
+splitmix64(uint64_t &x)
+{
+	uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/*
+ * xoshiro256++ (Blackman and Vigna): 64-bit values with a period of
+ * 2^256 - 1, a handful of instructions per value, seeded and so
+ * reproducible. It can be used with the <random> distributions.
+ *
+ * jump() moves the generator 2^128 values ahead. Generators for threads
+ * are copies of one generator jumped 1, 2, ... times, so their streams
+ * never overlap.
+ */
+class xoshiro256pp
+{
+private:
+	uint64_t _s[4];
+
+	static uint64_t rotl(uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+
+public:
+	typedef uint64_t result_type;
+
+	explicit xoshiro256pp(uint64_t seed = 1)
+	{
+		for (int i = 0; i < 4; ++i)
+			_s[i] = splitmix64(seed);
+	}
+
+	static constexpr result_type min()
+	{
+		return 0;
+	}
+
+	static constexpr result_type max()
+	{
+		return UINT64_MAX;
+	}
+
+	result_type operator()()
+	{
+		uint64_t result = rotl(_s[0] + _s[3], 23) + _s[0];
+		uint64_t t = _s[1] << 17;
+
+		_s[2] ^= _s[0];
+		_s[3] ^= _s[1];
+		_s[1] ^= _s[2];
+		_s[0] ^= _s[3];
+		_s[2] ^= t;
+		_s[3] = rotl(_s[3], 45);
+
+		return result;
+	}
+
+	void jump()
+	{
+		static const uint64_t poly[4] = {
+			0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+			0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+		};
+		uint64_t s[4] = { 0, 0, 0, 0 };
+
+		for (int i = 0; i < 4; ++i) {
+			for (int b = 0; b < 64; ++b) {
+				if (poly[i] & (uint64_t(1) << b)) {
+					for (int j = 0; j < 4; ++j)
+						s[j] ^= _s[j];
+				}
+				(*this)();
+			}
+		}
+
+		for (int j = 0; j < 4; ++j)
+			_s[j] = s[j];
+	}
+};
+
+/*
+ * A uniform value in [0, range), range > 0 (Lemire's multiply and shift,
+ * which divides only when a value has to be rejected, rarely).
+ */
+template<typename G>
+uint64_t
+uniform_below(G &gen, uint64_t range)
+{
+	__uint128_t m = static_cast<__uint128_t>(gen()) * range;
+	uint64_t low = static_cast<uint64_t>(m);
+
+	if (low < range) {
+		uint64_t threshold = -range % range;
+		while (low < threshold) {
+			m = static_cast<__uint128_t>(gen()) * range;
+			low = static_cast<uint64_t>(m);
+		}
+	}
+
+	return static_cast<uint64_t>(m >> 64);
+}
+
+/*
+ * One generator per stream: gens[i] is gen jumped i + 1 times.
+ */
+inline vector<xoshiro256pp>
+prng_streams(xoshiro256pp gen, size_t n)
+{
+	vector<xoshiro256pp> gens;
+
+	gens.reserve(n);
+	for (size_t i = 0; i < n; ++i) {
+		gen.jump();
+		gens.push_back(gen);
+	}
+	return gens;
+}
+
+/*
+ * Random bits, a 64-bit word at a time.
+ */
+template<typename G>
+class random_bits
+{
+private:
+	G &_gen;
+	uint64_t _word;
+	int _left;
+
+public:
+	explicit random_bits(G &gen) : _gen(gen), _word(0), _left(0)
+	{
+	}
+
+	bool operator()()
+	{
+		if (_left == 0) {
+			_word = _gen();
+			_left = 64;
+		}
+		bool bit = _word & 1;
+		_word >>= 1;
+		_left--;
+		return bit;
+	}
+};
+
+/*
+ * Fisher-Yates shuffle of [first, last).
+ */
+template<typename T, typename G>
+void
+fisher_yates(T *first, T *last, G &gen)
+{
+	size_t n = last - first;
+
+	for (size_t i = n; i > 1; --i) {
+		size_t r = uniform_below(gen, i);
+		swap(first[i - 1], first[r]);
+	}
+}
+
+/*
+ * Merge two shuffled halves [first, mid) and [mid, last) into a shuffle of
+ * [first, last): each position takes the head of a random half until one
+ * of them runs out, and the rest are put in place like Fisher-Yates
+ * would (MergeShuffle, Bacher, Bodini, Hollender and Lumbroso).
+ */
+template<typename T, typename G>
+void
+merge_shuffled(T *first, T *mid, T *last, G &gen)
+{
+	random_bits<G> coin(gen);
+	T *u = first;
+	T *v = mid;
+
+	for (;;) {
+		if (coin()) {
+			if (v == last)
+				break;
+			swap(*u, *v);
+			v++;
+		} else if (u == v) {
+			break;
+		}
+		u++;
+	}
+
+	for (; u < last; ++u) {
+		size_t r = uniform_below(gen, static_cast<uint64_t>(u - first + 1));
+		swap(first[r], *u);
+	}
+}
+
+constexpr size_t shuffle_grain = 1 << 16;      // fewest elements per part
+constexpr size_t shuffle_max_parts = 64;       // most parts
+
+/*
+ * Run func(0), ..., func(ntasks - 1) on up to nthreads threads; every
+ * thread takes the next task until none is left.
+ */
+template<typename F>
+void
+run_tasks(size_t ntasks, size_t nthreads, F func)
+{
+	atomic<size_t> next(0);
+
+	run_parallel(max<size_t>(min(nthreads, ntasks), 1), [&](size_t) {
+		for (size_t i = next++; i < ntasks; i = next++)
+			func(i);
+	});
+}
+
+/*
+ * Parallel shuffle. The elements are cut into a power of 2 number of
+ * parts, the most with at least shuffle_grain elements each (up to
+ * shuffle_max_parts); each part is shuffled with Fisher-Yates, and
+ * neighbouring parts are merged with merge_shuffled(), the merges of a
+ * level side by side, until one part is left. Every part and every merge
+ * has a stream of its own. The parts depend on n only, and the threads
+ * just share out the parts and the merges, so for a given gen the result
+ * is the same with any number of threads.
+ *
+ * @param [inout] elements - the vector to shuffle.
+ * @param [in]    gen      - the generator the streams are jumped from.
+ * @param [in]    nthreads - number of threads (0: one per core).
+ */
+template<typename T>
+void
+parallel_shuffle(vector<T> &elements, const xoshiro256pp &gen, size_t nthreads = 0)
+{
+	size_t n = elements.size();
+	size_t parts = 1;
+
+	if (nthreads == 0)
+		nthreads = default_threads();
+	while ((parts < shuffle_max_parts) && (n / (2 * parts) >= shuffle_grain))
+		parts *= 2;
+
+	vector<xoshiro256pp> gens = prng_streams(gen, 2 * parts - 1);
+	vector<size_t> bounds(parts + 1);
+	T *data = elements.data();
+
+	for (size_t i = 0; i <= parts; ++i)
+		bounds[i] = n / parts * i + min(i, n % parts);
+
+	run_tasks(parts, nthreads, [&](size_t t) {
+		fisher_yates(data + bounds[t], data + bounds[t + 1], gens[t]);
+	});
+
+	size_t stream = parts;
+	for (size_t width = 1; width < parts; width *= 2) {
+		size_t merges = parts / (2 * width);
+
+		run_tasks(merges, nthreads, [&](size_t m) {
+			size_t lo = bounds[2 * m * width];
+			size_t mid = bounds[(2 * m + 1) * width];
+			size_t hi = bounds[(2 * m + 2) * width];
+			merge_shuffled(data + lo, data + mid, data + hi, gens[stream + m]);
+		});
+		stream += merges;
+	}
+}
+
+#endif // PRNG_H_
@@ -0,0 +1,228 @@
+#if !defined(QUANTILE_H_)
+#define QUANTILE_H_
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+
+using namespace std;
+
+/*
+ * KLL quantile sketch (Karnin, Lang and Liberty).
+ *
+ * Approximate quantiles of a stream in bounded memory, without keeping the
+ * stream. The items are kept in levels; an item at level h stands for 2^h
+ * items of the stream. When the sketch is full, the lowest level over its
+ * capacity is sorted and every other item of it (starting at a random
+ * one) moves up a level, which halves that level at the cost of a small,
+ * unbiased rank error. Capacities shrink by 2/3 per level down from the
+ * top, so about 3 * k items are kept however long the stream is.
+ *
+ * Sketches of parts of a stream (e.g. one per thread) can be merged, and
+ * the result is as accurate as a sketch of the whole stream.
+ */
+template<typename T>
+class kll_sketch
+{
+private:
+	size_t _k;
+	uint64_t _n;
+	size_t _size;
+	size_t _capacity;
+	uint64_t _seed;
+	vector<vector<T>> _levels;
+	vector<size_t> _capacities;
+	T _min;
+	T _max;
+
+	/*
+	 * Recompute the level capacities after the number of levels changed.
+	 */
+	void update_capacity()
+	{
+		_capacities.resize(_levels.size());
+		_capacity = 0;
+		for (size_t h = 0; h < _levels.size(); ++h) {
+			double c = _k * pow(2.0 / 3, static_cast<double>(_levels.size() - 1 - h));
+			_capacities[h] = max<size_t>(2, static_cast<size_t>(ceil(c)));
+			_capacity += _capacities[h];
+		}
+	}
+
+	bool coin()
+	{
+		_seed ^= _seed << 13;
+		_seed ^= _seed >> 7;
+		_seed ^= _seed << 17;
+		return _seed & 1;
+	}
+
+	/*
+	 * Compact the lowest level that is over its capacity.
+	 */
+	void compress()
+	{
+		for (size_t h = 0; h < _levels.size(); ++h) {
+			if (_levels[h].size() < _capacities[h])
+				continue;
+
+			if (h + 1 == _levels.size()) {
+				_levels.emplace_back();
+				update_capacity();
+			}
+
+			vector<T> &level = _levels[h];
+			vector<T> &up = _levels[h + 1];
+			size_t odd = level.size() % 2;
+
+			sort(level.begin(), level.end());
+
+			/*
+			 * With an odd number of items the smallest one stays, so
+			 * that the weights still add up to n.
+			 */
+			for (size_t i = odd + coin(); i < level.size(); i += 2)
+				up.push_back(std::move(level[i]));
+
+			size_t before = level.size();
+			level.resize(odd);
+			_size -= before - odd - (before - odd) / 2;
+			return;
+		}
+	}
+
+public:
+	explicit kll_sketch(size_t k = 200, uint64_t seed = 0x9e3779b97f4a7c15ULL)
+		: _k(max<size_t>(k, 8)), _n(0), _size(0), _capacity(0), _seed(seed | 1), _levels(1)
+	{
+		update_capacity();
+	}
+
+	void update(const T &x)
+	{
+		if ((_n == 0) || (x < _min))
+			_min = x;
+		if ((_n == 0) || (_max < x))
+			_max = x;
+
+		_levels[0].push_back(x);
+		_n++;
+		_size++;
+		while (_size >= _capacity)
+			compress();
+	}
+
+	/*
+	 * Add the items of another sketch with the same k.
+	 */
+	void merge(const kll_sketch &other)
+	{
+		if (other._k != _k)
+			throw invalid_argument("kll_sketch: merging sketches of different k");
+
+		while (_levels.size() < other._levels.size())
+			_levels.emplace_back();
+		update_capacity();
+
+		if (other._n == 0)
+			return;
+
+		if ((_n == 0) || (other._min < _min))
+			_min = other._min;
+		if ((_n == 0) || (_max < other._max))
+			_max = other._max;
+
+		for (size_t h = 0; h < other._levels.size(); ++h)
+			_levels[h].insert(_levels[h].end(), other._levels[h].begin(), other._levels[h].end());
+
+		_n += other._n;
+		_size += other._size;
+		while (_size >= _capacity)
+			compress();
+	}
+
+	/*
+	 * Number of items in the stream.
+	 */
+	uint64_t count() const
+	{
+		return _n;
+	}
+
+	/*
+	 * Number of items kept.
+	 */
+	size_t size() const
+	{
+		return _size;
+	}
+
+	/*
+	 * Bound of the rank error of a quantile, as a fraction of n, at 99%
+	 * confidence. This is the empirical fit of the Apache DataSketches KLL
+	 * implementation, whose compaction scheme this follows.
+	 */
+	double rank_error() const
+	{
+		return 2.296 / pow(static_cast<double>(_k), 0.9723);
+	}
+
+	/*
+	 * Estimate the quantiles qs (fractions in [0, 1]): the item of rank
+	 * ceil(q * n), like percentiles of select_kth(). The smallest and
+	 * largest items are kept apart, so p0 and p100 are exact.
+	 *
+	 * @param [in]    qs       - the quantiles, in any order.
+	 *
+	 * @return the estimate for every q in qs, in the same order.
+	 */
+	vector<T> quantiles(const vector<double> &qs) const
+	{
+		vector<pair<const T *, uint64_t>> items;
+		vector<T> result;
+
+		if (_n == 0)
+			throw out_of_range("kll_sketch: no items");
+
+		items.reserve(_size);
+		for (size_t h = 0; h < _levels.size(); ++h) {
+			for (const T &x : _levels[h])
+				items.emplace_back(&x, uint64_t(1) << h);
+		}
+
+		sort(items.begin(), items.end(),
+			[](const pair<const T *, uint64_t> &a, const pair<const T *, uint64_t> &b) {
+				return *a.first < *b.first;
+			});
+
+		for (double q : qs) {
+			uint64_t rank = max<uint64_t>(static_cast<uint64_t>(ceil(q * _n)), 1);
+			uint64_t sum = 0;
+			size_t i = 0;
+
+			if ((rank == 1) || (rank >= _n)) {
+				result.push_back((rank == 1) ? _min : _max);
+				continue;
+			}
+
+			for (; i + 1 < items.size(); ++i) {
+				sum += items[i].second;
+				if (sum >= rank)
+					break;
+			}
+			result.push_back(*items[i].first);
+		}
+
+		return result;
+	}
+
+	T quantile(double q) const
+	{
+		return quantiles(vector<double>(1, q))[0];
+	}
+};
+
+#endif // QUANTILE_H_
@@ -0,0 +1,492 @@
+#if !defined(RADIX_H_)
+#define RADIX_H_
+
+#include <vector>
+#include <string>
+#include <type_traits>
+#include <climits>
+#include <cstdint>
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include "histogram.h"
+
+using namespace std;
+
+/*
+ * Map an integer key to an unsigned key with the same order. For signed
+ * types the sign bit is flipped, so negative numbers sort before positive
+ * numbers.
+ */
+template<typename T>
+static inline typename make_unsigned<T>::type
+radix_key(T value)
+{
+	typedef typename make_unsigned<T>::type U;
+	constexpr U flip = is_signed<T>::value ? (U(1) << (sizeof(T) * CHAR_BIT - 1)) : 0;
+	return static_cast<U>(value) ^ flip;
+}
+
+/*
+ * LSD radix sort of elements on an integer key (32 or 64 bit, signed or
+ * unsigned) taken from each element by key().
+ *
+ * The key is split into digits of digit_bits bits each (8, 11 and 16 are
+ * the usual choices) and one key index counting pass is done per digit,
+ * from the least significant digit to the most significant digit. The
+ * sort is stable, so elements with equal keys keep their order.
+ *
+ * - On one thread, the histograms of all the digits are computed in a
+ *   single read of the input.
+ * - A pass where every key has the same digit would only copy the data;
+ *   such passes are skipped.
+ * - The passes alternate between elements and a single auxiliary vector.
+ * - With threads, every pass counts and scatters one chunk per thread, at
+ *   offsets that keep the sort stable (see histogram.h). The chunks hold
+ *   other keys after every pass, so each pass counts its own digit.
+ *
+ * @param [inout] elements   - the vector to sort.
+ * @param [in]    key        - returns the key of an element.
+ * @param [in]    digit_bits - the number of bits in a digit (1 - 16).
+ * @param [in]    nthreads   - the number of threads (0: one per core).
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T, typename F>
+void
+lsd_radix_sort_by(vector<T> &elements, F key, unsigned digit_bits = 8, size_t nthreads = 1)
+{
+	typedef typename decay<decltype(key(elements[0]))>::type K;
+	static_assert(is_integral<K>::value, "LSD radix sort needs integer keys");
+
+	typedef typename make_unsigned<K>::type U;
+	constexpr unsigned key_bits = sizeof(K) * CHAR_BIT;
+
+	if ((digit_bits == 0) || (digit_bits > 16))
+		digit_bits = 8;
+
+	size_t n = elements.size();
+	if (n <= 1)
+		return;
+
+	const unsigned passes = (key_bits + digit_bits - 1) / digit_bits;
+	const size_t radix = size_t(1) << digit_bits;
+	const U mask = static_cast<U>(radix - 1);
+
+	nthreads = histogram_threads(n, nthreads);
+
+	/*
+	 * count[p * radix + d] is the number of keys with digit d in pass p.
+	 */
+	vector<size_t> count;
+
+	if (nthreads == 1) {
+		parallel_histogram(n, passes * radix, 1, [&](size_t lo, size_t hi, size_t *hist) {
+			for (size_t i = lo; i < hi; ++i) {
+				U k = radix_key(key(elements[i]));
+				for (unsigned p = 0; p < passes; ++p)
+					hist[p * radix + ((k >> (p * digit_bits)) & mask)]++;
+			}
+		}, count);
+	}
+
+	vector<T> aux(n);
+	vector<size_t> bounds(radix + 1);
+	T *src = elements.data();
+	T *dst = aux.data();
+
+	for (unsigned p = 0; p < passes; ++p) {
+		unsigned shift = p * digit_bits;
+		auto digit = [&](const T &e) { return (radix_key(key(e)) >> shift) & mask; };
+		size_t *c;
+
+		if (nthreads == 1) {
+			c = &count[p * radix];
+		} else {
+			parallel_histogram(n, radix, nthreads, [&](size_t lo, size_t hi, size_t *hist) {
+				for (size_t i = lo; i < hi; ++i)
+					hist[digit(src[i])]++;
+			}, count);
+			c = count.data();
+		}
+
+		// c[t * radix + d] becomes where chunk t puts its first key with digit d.
+		scatter_offsets(c, nthreads, radix, bounds.data());
+
+		// all keys have the same digit: nothing to do in this pass.
+		size_t d0 = digit(src[0]);
+		if (bounds[d0 + 1] - bounds[d0] == n)
+			continue;
+
+		run_parallel(nthreads, [&](size_t t) {
+			size_t lo, hi;
+			histogram_chunk(n, nthreads, t, lo, hi);
+			size_t *next = c + t * radix;
+			for (size_t i = lo; i < hi; ++i)
+				dst[next[digit(src[i])]++] = src[i];
+		});
+
+		swap(src, dst);
+	}
+
+	// Odd number of passes: the sorted keys are in the auxiliary vector.
+	if (src != elements.data())
+		elements.swap(aux);
+}
+
+/*
+ * LSD radix sort for integers: the elements are their own keys.
+ */
+template<typename T>
+void
+lsd_radix_sort(vector<T> &elements, unsigned digit_bits = 8, size_t nthreads = 1)
+{
+	lsd_radix_sort_by(elements, [](const T &v) { return v; }, digit_bits, nthreads);
+}
+
+/*
+ * Rearrange elements so that elements[i] becomes the old elements[perm[i]].
+ * Every cycle of the permutation is followed once and the elements are
+ * moved, not copied. perm is used to mark the finished positions and is
+ * the identity on return.
+ *
+ * @param [inout] elements - the vector to rearrange.
+ * @param [inout] perm     - the permutation.
+ */
+template<typename T, typename I>
+void
+apply_permutation(vector<T> &elements, vector<I> &perm)
+{
+	for (size_t i = 0; i < perm.size(); ++i) {
+		if (perm[i] == i)
+			continue;
+
+		T tmp = std::move(elements[i]);
+		size_t j = i;
+
+		while (perm[j] != i) {
+			size_t next = perm[j];
+			elements[j] = std::move(elements[next]);
+			perm[j] = static_cast<I>(j);
+			j = next;
+		}
+
+		elements[j] = std::move(tmp);
+		perm[j] = static_cast<I>(j);
+	}
+}
+
+/*
+ * Get the byte at the specified index in the given string,
+ * 0 if the index is beyond the string length.
+ */
+static inline unsigned char
+byte_at(const string &s, size_t i)
+{
+	return (i < s.length()) ? static_cast<unsigned char>(s[i]) : 0;
+}
+
+/*
+ * LSD radix sort on the indices of the strings.
+ */
+template<typename I>
+static void
+lsd_radix_sort_index(vector<string> &elements, size_t max_width)
+{
+	constexpr size_t N = 256;
+	size_t n = elements.size();
+
+	vector<I> idx(n);           // the strings in sorted order so far
+	vector<I> tmp(n);           // scratch for the next order
+	vector<unsigned char> key(n); // key[i] is the current byte of string idx[i]
+	array<size_t, N> count;
+
+	for (size_t i = 0; i < n; ++i)
+		idx[i] = static_cast<I>(i);
+
+	for (size_t w = max_width; w > 0; --w) {
+		count.fill(0);
+
+		/*
+		 * The only random access of the pass: gather the byte of every
+		 * string once. Counting and distribution read key[] sequentially.
+		 */
+		for (size_t i = 0; i < n; ++i) {
+			key[i] = byte_at(elements[idx[i]], w - 1);
+			count[key[i]]++;
+		}
+
+		// all strings have the same byte at this index: nothing to do.
+		if (count[key[0]] == n)
+			continue;
+
+		exclusive_prefix_sum(count.data(), N);
+
+		for (size_t i = 0; i < n; ++i)
+			tmp[count[key[i]]++] = idx[i];
+
+		idx.swap(tmp);
+	}
+
+	apply_permutation(elements, idx);
+}
+
+/*
+ * LSD radix sort for strings that does not copy strings.
+ *
+ * lsd_radix_sort_v1 and lsd_radix_sort_v2 copy every string once or twice
+ * per pass; each copy allocates. This version sorts the indices of the
+ * strings instead (32-bit indices when possible) using one scratch vector
+ * and a byte cache, then moves each string to its place exactly once.
+ * The memory traffic per pass is a few bytes per string.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [in]    max_width - the maximum size of string across
+ *                            all elements of the vector.
+ *
+ * @return elements are sorted on return.
+ */
+inline void
+lsd_radix_sort_v3(vector<string> &elements, size_t max_width)
+{
+	if (elements.size() <= 1)
+		return;
+
+	if (elements.size() <= UINT32_MAX)
+		lsd_radix_sort_index<uint32_t>(elements, max_width);
+	else
+		lsd_radix_sort_index<size_t>(elements, max_width);
+}
+
+/*
+ * Get the 8 bytes of the string starting at index depth as a big-endian
+ * integer, padded with 0 beyond the string length. Comparing two such
+ * integers compares 8 characters at once.
+ */
+static inline uint64_t
+key_at(const string &s, size_t depth)
+{
+	size_t len = s.length();
+	uint64_t key = 0;
+
+	if (depth + 8 <= len) {
+		memcpy(&key, s.data() + depth, 8);
+#if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+		key = __builtin_bswap64(key);
+#endif
+		return key;
+	}
+
+	for (size_t i = depth; i < depth + 8; ++i)
+		key = (key << 8) | ((i < len) ? static_cast<unsigned char>(s[i]) : 0);
+	return key;
+}
+
+/*
+ * Compare two strings with the same first depth characters, given their
+ * 8-byte keys at depth.
+ */
+static inline bool
+less_from(const string *a, uint64_t ka, const string *b, uint64_t kb, size_t depth)
+{
+	if (ka != kb)
+		return ka < kb;
+	// equal keys ending in 0: both strings ended.
+	if ((ka & 0xff) == 0)
+		return false;
+	return a->compare(depth + 8, string::npos, *b, depth + 8, string::npos) < 0;
+}
+
+/*
+ * Hybrid MSD radix sort.
+ *
+ * msd_radix_sort copies the strings to an auxiliary vector at every level,
+ * keeps two count arrays per recursion and recurses down to buckets of one
+ * string. This version:
+ * - sorts pointers to the strings; each string is moved once at the end.
+ * - distributes large buckets in place (American flag sort). The byte of
+ *   every string at the current depth is cached in a side array first, so
+ *   the counting and the permutation do not touch the strings again.
+ *   Bytes common to the whole bucket are skipped 8 at a time.
+ * - sorts medium buckets with 3-way string quicksort (multikey quicksort)
+ *   on the next 8 bytes of every string, cached as an integer. The smaller
+ *   and larger parts keep their cached keys; the equal part moves 8 bytes
+ *   deeper.
+ * - sorts small buckets with insertion sort on the cached keys.
+ * - replaces recursion with an explicit stack of buckets, so long common
+ *   prefixes cannot overflow the call stack.
+ *
+ * Like msd_radix_sort, a 0 byte is treated as the end of the string.
+ *
+ * @param [inout] elements  - the vector to sort.
+ *
+ * @return elements are sorted on return.
+ */
+inline void
+msd_radix_sort_v2(vector<string> &elements)
+{
+	constexpr size_t N = 256;
+	constexpr size_t insertion_cutoff = 16;     // insertion sort below this
+	constexpr size_t quick_cutoff = 1024;       // multikey quicksort below this
+
+	struct bucket
+	{
+		size_t  lo;         // first string
+		size_t  hi;         // one past the last string
+		size_t  depth;      // all strings in [lo, hi) have the same depth first bytes
+		bool    cached;     // keys[lo, hi) hold the 8 bytes at depth
+	};
+
+	size_t n = elements.size();
+	if (n <= 1)
+		return;
+
+	vector<string *> ptrs(n);
+	vector<uint64_t> keys(n);           // keys[i] is the 8 bytes of ptrs[i] at depth
+	vector<unsigned char> cache(n);     // cache[i] is the byte of ptrs[i] the radix step looks at
+	vector<bucket> stk;
+	array<size_t, N> count;
+	array<size_t, N> head;              // next free slot in a bucket
+	array<size_t, N> tail;              // one past the end of a bucket
+
+	for (size_t i = 0; i < n; ++i)
+		ptrs[i] = &elements[i];
+
+	stk.push_back({ 0, n, 0, false });
+
+	while (!stk.empty()) {
+		bucket b = stk.back();
+		stk.pop_back();
+
+		size_t size = b.hi - b.lo;
+
+		if (size < quick_cutoff) {
+			if (!b.cached) {
+				for (size_t i = b.lo; i < b.hi; ++i)
+					keys[i] = key_at(*ptrs[i], b.depth);
+			}
+
+			if (size < insertion_cutoff) {
+				for (size_t i = b.lo + 1; i < b.hi; ++i) {
+					string *p = ptrs[i];
+					uint64_t k = keys[i];
+					size_t j = i;
+					while ((j > b.lo) && less_from(p, k, ptrs[j - 1], keys[j - 1], b.depth)) {
+						ptrs[j] = ptrs[j - 1];
+						keys[j] = keys[j - 1];
+						--j;
+					}
+					ptrs[j] = p;
+					keys[j] = k;
+				}
+				continue;
+			}
+
+			/*
+			 * Multikey quicksort step: 3-way partition on the cached keys
+			 * around the median of three.
+			 */
+			uint64_t x = keys[b.lo];
+			uint64_t y = keys[b.lo + size / 2];
+			uint64_t z = keys[b.hi - 1];
+			uint64_t v = max(min(x, y), min(max(x, y), z));
+
+			size_t lt = b.lo;
+			size_t gt = b.hi;
+			size_t i = b.lo;
+
+			while (i < gt) {
+				if (keys[i] < v) {
+					swap(ptrs[lt], ptrs[i]);
+					swap(keys[lt++], keys[i++]);
+				} else if (keys[i] > v) {
+					--gt;
+					swap(ptrs[i], ptrs[gt]);
+					swap(keys[i], keys[gt]);
+				} else {
+					i++;
+				}
+			}
+
+			if (lt - b.lo > 1)
+				stk.push_back({ b.lo, lt, b.depth, true });
+			if (b.hi - gt > 1)
+				stk.push_back({ gt, b.hi, b.depth, true });
+			// the equal strings go 8 bytes deeper, unless they all ended.
+			if (((v & 0xff) != 0) && (gt - lt > 1))
+				stk.push_back({ lt, gt, b.depth + 8, false });
+			continue;
+		}
+
+		/*
+		 * American flag sort step. The 8 bytes at depth are read once; the
+		 * bytes that all strings have in common are skipped and the strings
+		 * are distributed on the first byte that differs.
+		 */
+		uint64_t kmin = UINT64_MAX;
+		uint64_t kmax = 0;
+		for (size_t i = b.lo; i < b.hi; ++i) {
+			keys[i] = key_at(*ptrs[i], b.depth);
+			kmin = min(kmin, keys[i]);
+			kmax = max(kmax, keys[i]);
+		}
+
+		// all strings have the same 8 bytes: look 8 bytes deeper.
+		if (kmin == kmax) {
+			if ((kmin & 0xff) != 0)
+				stk.push_back({ b.lo, b.hi, b.depth + 8, false });
+			continue;
+		}
+
+		size_t skip = __builtin_clzll(kmin ^ kmax) / 8;
+		unsigned shift = 56 - 8 * skip;
+
+		count.fill(0);
+		for (size_t i = b.lo; i < b.hi; ++i) {
+			cache[i] = static_cast<unsigned char>(keys[i] >> shift);
+			count[cache[i]]++;
+		}
+
+		head = count;
+		exclusive_prefix_sum(head.data(), N, b.lo);
+		for (size_t c = 0; c < N; ++c)
+			tail[c] = head[c] + count[c];
+
+		/*
+		 * Permute in place: pick the first misplaced string of a bucket and
+		 * keep swapping it into the bucket it belongs to until a string that
+		 * belongs here comes back.
+		 */
+		for (size_t c = 0; c < N; ++c) {
+			while (head[c] < tail[c]) {
+				size_t i = head[c];
+				string *p = ptrs[i];
+				unsigned char k = cache[i];
+
+				while (k != c) {
+					size_t j = head[k]++;
+					swap(p, ptrs[j]);
+					swap(k, cache[j]);
+				}
+
+				ptrs[i] = p;
+				cache[i] = k;
+				head[c]++;
+			}
+		}
+
+		// bucket 0 holds the strings that ended: already sorted.
+		for (size_t c = 1, lo = b.lo + count[0]; c < N; lo += count[c], ++c) {
+			if (count[c] > 1)
+				stk.push_back({ lo, lo + count[c], b.depth + skip + 1, false });
+		}
+	}
+
+	vector<string> sorted;
+	sorted.reserve(n);
+	for (auto p : ptrs)
+		sorted.push_back(std::move(*p));
+	elements.swap(sorted);
+}
+
+#endif // RADIX_H_
@@ -1,49 +1,80 @@
 #include <iostream>
 #include <iomanip>
+#include <vector>
 #include <random>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include "prng.h"
 
-static std::random_device rd;
-
-static size_t
-get_random_in_range(size_t start, size_t end)
-{
-	std::uniform_int_distribution<size_t> dist(start, end);
-	return dist(rd);
-}
+using namespace std;
 
 static void
-shuffle(int array[], size_t count)
+dump_array(const vector<int> &array)
 {
-	for (size_t i = 0; i < count; i++) {
-		size_t r =  get_random_in_range(0, i);
-		if (i != r) {
-			std::swap(array[i], array[r]);
-		}
-	}
+	for (size_t i = 0; i < array.size(); ++i)
+		cout << setw(4) << array[i];
+	cout << endl;
 }
 
-static void
-dump_array(int array[], size_t count)
+static int
+usage(const char *progname)
 {
-	for (size_t i = 0; i < count; ++i)
-		std::cout << std::setw(4) << array[i];
-	std::cout << std::endl;
+	cerr << progname << " <count> [-seed <seed>] [-threads <n>] [-quiet]" << endl
+		<< "    -seed <seed>    Random seed (default a random one)." << endl
+		<< "    -threads <n>    Shuffle with n threads (default one per core)." << endl
+		<< "    -quiet          Print the time taken instead of the elements." << endl;
+	return 1;
 }
 
 int
-main(int, const char **argv)
+main(int argc, const char **argv)
 {
-	size_t n = atoi(argv[1]);
-	int *array = new int[n];
+	if ((argc < 2) || (argv[1][0] == '-'))
+		return usage(argv[0]);
+
+	size_t n = strtoull(argv[1], nullptr, 10);
+	uint64_t seed = random_device()();
+	size_t nthreads = 0;
+	bool quiet = false;
+
+	for (int i = 2; i < argc; ++i) {
+		if (strcmp(argv[i], "-quiet") == 0) {
+			quiet = true;
+			continue;
+		}
+
+		if (argv[i + 1] == nullptr) {
+			cerr << "missing argument for " << argv[i] << endl;
+			return usage(argv[0]);
+		}
+
+		if (strcmp(argv[i], "-seed") == 0) {
+			seed = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-threads") == 0) {
+			nthreads = strtoull(argv[++i], nullptr, 10);
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	vector<int> array(n);
 
 	for (size_t i = 0; i < n; ++i)
-		array[i] = i;
+		array[i] = static_cast<int>(i);
 
-	dump_array(array, n);
+	if (!quiet)
+		dump_array(array);
 
-	shuffle(array, n);
+	chrono::time_point<chrono::high_resolution_clock> start = chrono::high_resolution_clock::now();
+	parallel_shuffle(array, xoshiro256pp(seed), nthreads);
+	chrono::time_point<chrono::high_resolution_clock> stop = chrono::high_resolution_clock::now();
 
-	dump_array(array, n);
+	if (quiet)
+		cout << chrono::duration_cast<chrono::microseconds>(stop - start).count() << endl;
+	else
+		dump_array(array);
 
 	return 0;
 }
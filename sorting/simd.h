@@ -0,0 +1,592 @@
+#if !defined(SIMD_H_)
+#define SIMD_H_
+
+#include <vector>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86    1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+/*
+ * Vectorized kernels for int keys.
+ *
+ * - Sorting networks for 8 to 64 ints (AVX2: 8 lanes, SSE4.1: 4 lanes).
+ * - A partition that compares 8 ints at once and moves them to either
+ *   side with one permute and two stores (AVX2).
+ * - A histogram of small byte values, 32 bytes at a time (AVX2); it is
+ *   used for the categories of a k-way partition (see kway.h), whatever
+ *   the type of the keys.
+ * - The sum of arrays of counters, 4 at a time (AVX2), to add up per-thread
+ *   histograms (see histogram.h).
+ *
+ * The kernels are compiled for their instruction set with function target
+ * attributes, so the rest of the program needs no special flags, and the
+ * instruction set is picked at run time. On other CPUs and compilers the
+ * callers fall back to their scalar code.
+ */
+
+enum simd_level
+{
+	SIMD_NONE,      // scalar code only
+	SIMD_SSE4,      // SSE4.1
+	SIMD_AVX2       // AVX2
+};
+
+/*
+ * The highest level the kernels may use; lowered by simd_limit().
+ */
+inline simd_level &
+simd_cap()
+{
+	static simd_level cap = SIMD_AVX2;
+	return cap;
+}
+
+/*
+ * Limit the kernels to the given level (for comparing the code paths).
+ */
+inline void
+simd_limit(simd_level level)
+{
+	simd_cap() = level;
+}
+
+/*
+ * The level the CPU supports, capped by simd_limit().
+ */
+inline simd_level
+simd_detect()
+{
+#if defined(SIMD_X86)
+	static const simd_level cpu =
+		__builtin_cpu_supports("avx2") ? SIMD_AVX2 :
+		__builtin_cpu_supports("sse4.1") ? SIMD_SSE4 : SIMD_NONE;
+	return min(cpu, simd_cap());
+#else
+	return SIMD_NONE;
+#endif
+}
+
+#if defined(SIMD_X86)
+
+#define SIMD_AVX2_FN    static inline __attribute__((target("avx2"), always_inline))
+#define SIMD_SSE4_FN    static inline __attribute__((target("sse4.1"), always_inline))
+
+/*
+ * Bitonic sorting network, all comparators ascending.
+ *
+ * For every merge size k = 2, 4, ..., N: element i is compared with
+ * i ^ (k - 1) (the two halves of every k block, one of them reversed),
+ * then with i ^ j for j = k / 4, ..., 1. The N = lanes * R elements are
+ * held in R registers, element i in lane i % lanes of register i / lanes.
+ * A comparator between registers is a min and a max; one inside a
+ * register also needs a lane permute and a blend.
+ */
+
+SIMD_AVX2_FN __m256i
+avx2_xor_lanes(__m256i v, int m)
+{
+	return _mm256_permutevar8x32_epi32(v, _mm256_xor_si256(
+		_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(m)));
+}
+
+/*
+ * Compare element i with element i ^ m for all i.
+ */
+template<int R>
+SIMD_AVX2_FN void
+avx2_compare(__m256i *r, int m)
+{
+	if (m < 8) {
+		// lanes with bit (top bit of m) clear keep the minimum.
+		int top = (m >= 4) ? 4 : (m >= 2) ? 2 : 1;
+		__m256i low = _mm256_cmpeq_epi32(_mm256_and_si256(
+			_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(top)), _mm256_setzero_si256());
+
+		for (int i = 0; i < R; ++i) {
+			__m256i p = avx2_xor_lanes(r[i], m);
+			r[i] = _mm256_blendv_epi8(_mm256_max_epi32(r[i], p), _mm256_min_epi32(r[i], p), low);
+		}
+		return;
+	}
+
+	int rm = m >> 3;
+	int top = 1;
+	while (top * 2 <= rm)
+		top *= 2;
+
+	for (int i = 0; i < R; ++i) {
+		if (i & top)
+			continue;
+		int j = i ^ rm;
+		if (m & 7) {
+			__m256i b = avx2_xor_lanes(r[j], 7);
+			__m256i lo = _mm256_min_epi32(r[i], b);
+			r[j] = avx2_xor_lanes(_mm256_max_epi32(r[i], b), 7);
+			r[i] = lo;
+		} else {
+			__m256i lo = _mm256_min_epi32(r[i], r[j]);
+			r[j] = _mm256_max_epi32(r[i], r[j]);
+			r[i] = lo;
+		}
+	}
+}
+
+template<int R>
+static __attribute__((target("avx2"))) void
+avx2_sort_network(int *a, size_t n)
+{
+	alignas(32) int buf[8 * R];
+	__m256i r[R];
+
+	memcpy(buf, a, n * sizeof(int));
+	for (size_t i = n; i < 8 * R; ++i)
+		buf[i] = INT_MAX;
+	for (int i = 0; i < R; ++i)
+		r[i] = _mm256_load_si256(reinterpret_cast<const __m256i *>(buf + 8 * i));
+
+	for (int k = 2; k <= 8 * R; k *= 2) {
+		avx2_compare<R>(r, k - 1);
+		for (int j = k / 4; j >= 1; j /= 2)
+			avx2_compare<R>(r, j);
+	}
+
+	for (int i = 0; i < R; ++i)
+		_mm256_store_si256(reinterpret_cast<__m256i *>(buf + 8 * i), r[i]);
+	memcpy(a, buf, n * sizeof(int));
+}
+
+SIMD_SSE4_FN __m128i
+sse4_xor_lanes(__m128i v, int m)
+{
+	switch (m & 3) {
+		case 1:
+			return _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1));
+		case 2:
+			return _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2));
+		case 3:
+			return _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+		default:
+			return v;
+	}
+}
+
+/*
+ * Compare element i with element i ^ m for all i.
+ */
+template<int R>
+SIMD_SSE4_FN void
+sse4_compare(__m128i *r, int m)
+{
+	if (m < 4) {
+		// lanes with bit (top bit of m) clear keep the minimum.
+		__m128i low = (m >= 2) ? _mm_setr_epi32(-1, -1, 0, 0) : _mm_setr_epi32(-1, 0, -1, 0);
+
+		for (int i = 0; i < R; ++i) {
+			__m128i p = sse4_xor_lanes(r[i], m);
+			r[i] = _mm_blendv_epi8(_mm_max_epi32(r[i], p), _mm_min_epi32(r[i], p), low);
+		}
+		return;
+	}
+
+	int rm = m >> 2;
+	int top = 1;
+	while (top * 2 <= rm)
+		top *= 2;
+
+	for (int i = 0; i < R; ++i) {
+		if (i & top)
+			continue;
+		int j = i ^ rm;
+		if (m & 3) {
+			__m128i b = sse4_xor_lanes(r[j], 3);
+			__m128i lo = _mm_min_epi32(r[i], b);
+			r[j] = sse4_xor_lanes(_mm_max_epi32(r[i], b), 3);
+			r[i] = lo;
+		} else {
+			__m128i lo = _mm_min_epi32(r[i], r[j]);
+			r[j] = _mm_max_epi32(r[i], r[j]);
+			r[i] = lo;
+		}
+	}
+}
+
+template<int R>
+static __attribute__((target("sse4.1"))) void
+sse4_sort_network(int *a, size_t n)
+{
+	alignas(16) int buf[4 * R];
+	__m128i r[R];
+
+	memcpy(buf, a, n * sizeof(int));
+	for (size_t i = n; i < 4 * R; ++i)
+		buf[i] = INT_MAX;
+	for (int i = 0; i < R; ++i)
+		r[i] = _mm_load_si128(reinterpret_cast<const __m128i *>(buf + 4 * i));
+
+	for (int k = 2; k <= 4 * R; k *= 2) {
+		sse4_compare<R>(r, k - 1);
+		for (int j = k / 4; j >= 1; j /= 2)
+			sse4_compare<R>(r, j);
+	}
+
+	for (int i = 0; i < R; ++i)
+		_mm_store_si128(reinterpret_cast<__m128i *>(buf + 4 * i), r[i]);
+	memcpy(a, buf, n * sizeof(int));
+}
+
+/*
+ * permutes[mask] moves the lanes whose mask bit is clear to the front and
+ * the others to the back, both in lane order. Lane index k of the
+ * permute is stored in bits [4k, 4k + 3].
+ */
+inline const uint32_t *
+avx2_partition_permutes()
+{
+	static const struct table
+	{
+		uint32_t perm[256];
+
+		table()
+		{
+			for (unsigned mask = 0; mask < 256; ++mask) {
+				uint32_t p = 0;
+				unsigned k = 0;
+				for (unsigned lane = 0; lane < 8; ++lane) {
+					if (!(mask & (1u << lane)))
+						p |= lane << (4 * k++);
+				}
+				for (unsigned lane = 0; lane < 8; ++lane) {
+					if (mask & (1u << lane))
+						p |= lane << (4 * k++);
+				}
+				perm[mask] = p;
+			}
+		}
+	} permutes;
+
+	return permutes.perm;
+}
+
+/*
+ * Partition 8 ints: the ones on the left side (less than the pivot if
+ * strict, not greater otherwise) are stored at wl, the others end at wr.
+ * Both stores write all 8 lanes; the caller keeps 8 free slots at either
+ * end.
+ */
+SIMD_AVX2_FN void
+avx2_partition_vector(__m256i v, __m256i pivot, bool strict, const uint32_t *permutes, int *&wl, int *&wr)
+{
+	__m256i left = strict ? _mm256_cmpgt_epi32(pivot, v) :
+		_mm256_xor_si256(_mm256_cmpgt_epi32(v, pivot), _mm256_set1_epi32(-1));
+	unsigned right = ~_mm256_movemask_ps(_mm256_castsi256_ps(left)) & 0xff;
+	unsigned nright = __builtin_popcount(right);
+
+	__m256i perm = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(permutes[right]),
+		_mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28)), _mm256_set1_epi32(7));
+	v = _mm256_permutevar8x32_epi32(v, perm);
+
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(wl), v);
+	wl += 8 - nright;
+	_mm256_storeu_si256(reinterpret_cast<__m256i *>(wr - 8), v);
+	wr -= nright;
+}
+
+/*
+ * Partition a[0, n) around pivot, in place: the ints less than the pivot
+ * (strict) or not greater than the pivot (!strict) go to the front.
+ *
+ * The first and last 8 ints are held in registers, which leaves 16 free
+ * slots. Every step reads 8 ints from the end with fewer free slots and
+ * writes them back to both ends, so the free slots never run out.
+ *
+ * @return the number of ints in the front part.
+ */
+static inline __attribute__((target("avx2,popcnt"))) size_t
+avx2_partition(int *a, size_t n, int pivot, bool strict)
+{
+	if (n < 16) {
+		size_t w = 0;
+		for (size_t i = 0; i < n; ++i) {
+			if (strict ? (a[i] < pivot) : (a[i] <= pivot))
+				swap(a[w++], a[i]);
+		}
+		return w;
+	}
+
+	const uint32_t *permutes = avx2_partition_permutes();
+	__m256i pv = _mm256_set1_epi32(pivot);
+	__m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a));
+	__m256i last = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + n - 8));
+
+	int *wl = a;            // next free slot at the front
+	int *wr = a + n;        // one past the last free slot at the back
+	int *rl = a + 8;        // next unread int
+	int *rr = a + n - 8;    // one past the last unread int
+
+	while (rr - rl >= 8) {
+		__m256i v;
+		if ((rl - wl) <= (wr - rr)) {
+			v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rl));
+			rl += 8;
+		} else {
+			rr -= 8;
+			v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rr));
+		}
+		avx2_partition_vector(v, pv, strict, permutes, wl, wr);
+	}
+
+	// fewer than 8 unread ints left; [wl, wr) is all free after this.
+	int rest[8];
+	size_t nrest = rr - rl;
+	memcpy(rest, rl, nrest * sizeof(int));
+	for (size_t i = 0; i < nrest; ++i) {
+		if (strict ? (rest[i] < pivot) : (rest[i] <= pivot))
+			*wl++ = rest[i];
+		else
+			*--wr = rest[i];
+	}
+
+	avx2_partition_vector(first, pv, strict, permutes, wl, wr);
+	avx2_partition_vector(last, pv, strict, permutes, wl, wr);
+
+	return wl - a;
+}
+
+/*
+ * Histogram of n bytes with values less than K: every vector of 32 bytes
+ * is compared with each value and the matches are counted in per-lane
+ * byte counters, which are summed into count[] before they overflow.
+ */
+template<size_t K>
+static inline __attribute__((target("avx2"))) void
+avx2_histogram(const uint8_t *bytes, size_t n, size_t *count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	size_t i = 0;
+
+	while (n - i >= 32) {
+		size_t end = i + 32 * min<size_t>(255, (n - i) / 32);
+		__m256i acc[K];
+
+		for (size_t c = 0; c < K; ++c)
+			acc[c] = zero;
+
+		for (; i < end; i += 32) {
+			__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + i));
+			for (size_t c = 0; c < K; ++c)
+				acc[c] = _mm256_sub_epi8(acc[c], _mm256_cmpeq_epi8(v, _mm256_set1_epi8(static_cast<char>(c))));
+		}
+
+		for (size_t c = 0; c < K; ++c) {
+			__m256i s = _mm256_sad_epu8(acc[c], zero);
+			count[c] += _mm256_extract_epi64(s, 0) + _mm256_extract_epi64(s, 1) +
+				_mm256_extract_epi64(s, 2) + _mm256_extract_epi64(s, 3);
+		}
+	}
+
+	for (; i < n; ++i)
+		count[bytes[i]]++;
+}
+
+/*
+ * dst[i] += src[i] for i in [0, n).
+ */
+static inline __attribute__((target("avx2"))) void
+avx2_add_counts(uint64_t *dst, const uint64_t *src, size_t n)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4) {
+		__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+		__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_add_epi64(d, s));
+	}
+
+	for (; i < n; ++i)
+		dst[i] += src[i];
+}
+
+#endif // SIMD_X86
+
+/*
+ * Sort a[0, n), n <= 64, with a sorting network.
+ *
+ * @return false if n is too large or no vector instruction set is
+ *         available; a is unchanged then.
+ */
+inline bool
+simd_sort_network(int *a, size_t n)
+{
+#if defined(SIMD_X86)
+	switch (simd_detect()) {
+		case SIMD_AVX2:
+			if (n <= 8)
+				avx2_sort_network<1>(a, n);
+			else if (n <= 16)
+				avx2_sort_network<2>(a, n);
+			else if (n <= 32)
+				avx2_sort_network<4>(a, n);
+			else if (n <= 64)
+				avx2_sort_network<8>(a, n);
+			else
+				return false;
+			return true;
+
+		case SIMD_SSE4:
+			if (n <= 8)
+				sse4_sort_network<2>(a, n);
+			else if (n <= 16)
+				sse4_sort_network<4>(a, n);
+			else if (n <= 32)
+				sse4_sort_network<8>(a, n);
+			else if (n <= 64)
+				sse4_sort_network<16>(a, n);
+			else
+				return false;
+			return true;
+
+		default:
+			break;
+	}
+#endif
+	return false;
+}
+
+/*
+ * Sort elements[lo, hi] with a sorting network if they are int and few
+ * enough (quick sort base case).
+ *
+ * @return true if sorted.
+ */
+template<typename T>
+inline bool
+simd_sort_small(vector<T> &, size_t, size_t)
+{
+	return false;
+}
+
+inline bool
+simd_sort_small(vector<int> &elements, size_t lo, size_t hi)
+{
+	return simd_sort_network(elements.data() + lo, hi - lo + 1);
+}
+
+/*
+ * Sort every run of 64 elements with a sorting network if the elements
+ * are int (merge sort base case).
+ *
+ * @return the length of the sorted runs: 64, or 1 if nothing was done.
+ */
+template<typename T>
+inline size_t
+simd_sort_runs(vector<T> &)
+{
+	return 1;
+}
+
+inline size_t
+simd_sort_runs(vector<int> &elements)
+{
+	constexpr size_t run = 64;
+
+	if (simd_detect() == SIMD_NONE)
+		return 1;
+
+	for (size_t lo = 0; lo < elements.size(); lo += run)
+		simd_sort_network(elements.data() + lo, min(run, elements.size() - lo));
+
+	return run;
+}
+
+/*
+ * 3-way partition of elements[lo, hi] around elements[lo], as partition()
+ * in sort.cpp, if the elements are int: one vector pass splits off the
+ * elements less than the pivot, a second one the elements equal to it
+ * from the rest.
+ *
+ * @return true if partitioned; elements[p1, p2] are then the elements
+ *         equal to the pivot.
+ */
+template<typename T>
+inline bool
+simd_partition3(vector<T> &, size_t, size_t, size_t &, size_t &)
+{
+	return false;
+}
+
+inline bool
+simd_partition3(vector<int> &elements, size_t lo, size_t hi, size_t &p1, size_t &p2)
+{
+#if defined(SIMD_X86)
+	if (simd_detect() != SIMD_AVX2)
+		return false;
+
+	int pivot = elements[lo];
+	int *a = elements.data() + lo;
+	size_t n = hi - lo + 1;
+
+	size_t nless = avx2_partition(a, n, pivot, true);
+	size_t nequal = avx2_partition(a + nless, n - nless, pivot, false);
+
+	p1 = lo + nless;
+	p2 = p1 + nequal - 1;
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*
+ * Add the histogram of bytes[0, n) to count[0, k); every byte is less
+ * than k.
+ *
+ * @return false if k is more than 8 or AVX2 is not available; count is
+ *         unchanged then.
+ */
+inline bool
+simd_histogram(const uint8_t *bytes, size_t n, size_t k, size_t *count)
+{
+#if defined(SIMD_X86)
+	if (simd_detect() != SIMD_AVX2)
+		return false;
+
+	switch (k) {
+		case 1: count[0] += n; return true;
+		case 2: avx2_histogram<2>(bytes, n, count); return true;
+		case 3: avx2_histogram<3>(bytes, n, count); return true;
+		case 4: avx2_histogram<4>(bytes, n, count); return true;
+		case 5: avx2_histogram<5>(bytes, n, count); return true;
+		case 6: avx2_histogram<6>(bytes, n, count); return true;
+		case 7: avx2_histogram<7>(bytes, n, count); return true;
+		case 8: avx2_histogram<8>(bytes, n, count); return true;
+		default: break;
+	}
+#endif
+	return false;
+}
+
+/*
+ * Add the counters src[0, n) to dst[0, n).
+ */
+inline void
+simd_add_counts(size_t *dst, const size_t *src, size_t n)
+{
+#if defined(SIMD_X86)
+	if ((sizeof(size_t) == sizeof(uint64_t)) && (simd_detect() == SIMD_AVX2)) {
+		avx2_add_counts(reinterpret_cast<uint64_t *>(dst), reinterpret_cast<const uint64_t *>(src), n);
+		return;
+	}
+#endif
+	for (size_t i = 0; i < n; ++i)
+		dst[i] += src[i];
+}
+
+#endif // SIMD_H_
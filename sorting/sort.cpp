@@ -4,946 +4,270 @@
 #include <fstream>
 #include <iomanip>
 #include <vector>
-#include <queue>
-#include <array>
 #include <string>
 #include <cstring>
 #include <chrono>
+#include <cmath>
+#include <algorithm>
+#include "sort.h"
+#include "argsort.h"
+#include "external.h"
+#include "input.h"
+#include "quantile.h"
 
 using namespace std;
 
-template<typename T>
-static ostream &
-operator<< (ostream &os, const vector<T> &values)
-{
-	typename vector<T>::const_iterator it;
-	for (it = values.begin(); it != values.end(); ++it) {
-		if (it != values.begin())
-			os << ", ";
-		os << *it;
-	}
-	return os;
-}
-
-template<typename T>
-static ostream &
-operator<< (ostream &os, const queue<T> &values)
-{
-	bool first = true;
-	queue<T> tmpq(values);
-
-	while (!tmpq.empty()) {
-		if (!first) {
-			os << ", ";	
-		} else {
-			first = false;
-		}
-		os << tmpq.front();
-		tmpq.pop();
-	}
-	return os;
-}
-
 /*
- * Get the character at the specified index in the
- * given string.
- *
- * @param [in] s - the given string.
- * @param [in] i - the given index.
- *
- * @return character at the specified index in the string.
- * If the index is beyond the string length, return 0.
+ * Parse a percentile like p99.9 into a fraction.
  */
-static int
-char_at(const std::string &s, size_t i)
-{
-	return (i < s.length()) ? s[i] : 0;
-}
-
-/*
- * LSD radix sort. This is a straight-forward  implementation
- * using:
- * - 1 main queue, initialized with input items.
- * - 256 auxiliary queues, one for every possible character [0-255].
- *
- * @param [inout] elements  - the vector to sort.
- * @paran [in]    max_width - the maximum size of string across
- *                            all elements of the vector.
- *
- * @return elements are sorted on return.
- */
-void
-lsd_radix_sort_v1(vector<string> &elements, size_t max_width)
+static bool
+parse_percentile(const string &item, double &q)
 {
-	constexpr int N = 256;
-	queue<string> mainq;
-
-	/*
-	 * 256 auxiliary queues: one for each valid character.
-	 */
-	array<queue<string>, N> auxq;
-
-	/*
-	 * Move all the strings to the main queue.
-	 * This queue is processed (sorted) at every valid
-	 * index position.
-	 */
-	for (auto e : elements)
-		mainq.push(e);
-	elements.clear();
-
-	/*
-	 * Repeat max_width times from least significant digit
-	 * (LSD) to most significant digit (MSD) sorting strings
-	 * based on the character at index w - 1.
-	 */
-	for (size_t w = max_width; w > 0; --w) {
-		/*
-		 * Read the strings from the main queue and
-		 * push the strings in the correct queue.
-		 */
-		while (!mainq.empty()) {
-			string s = mainq.front();
-			mainq.pop();
-			auxq[char_at(s, w - 1)].push(s);
-		}
-
-		/*
-		 * Copy the strings back from auxiliary queues
-		 * to the main queue.
-		 */
-		for (size_t j = 0; j < N; ++j) {
-			while (!auxq[j].empty()) {
-				mainq.push(auxq[j].front());
-				auxq[j].pop();
-			}
-		}
+	const char *p = item.c_str();
+	char *end;
 
-#if defined(DEBUG)
-		cout << "w = " << w << " : " << mainq << endl;
-#endif // DEBUG
-	}
+	if ((item.size() < 2) || (item[0] != 'p'))
+		return false;
 
-	/*
-	 * The main queue is sorted now!
-	 * Copy the strings from the main queue back to the
-	 * vector.
-	 */
-	while (!mainq.empty()) {
-		elements.push_back(mainq.front());
-		mainq.pop();
-	}
+	double v = strtod(p + 1, &end);
+	if ((*end != '\0') || !((v >= 0) && (v <= 100)))
+		return false;
 
-	return;
+	q = v / 100;
+	return true;
 }
 
 /*
- * LSD radix sort. The sort uses key index count sorting.
- *
- * @param [inout] elements  - the vector to sort.
- * @paran [in]    max_width - the maximum size of string across
- *                            all elements of the vector.
- *
- * @return elements are sorted on return.
+ * Index of the quantile q in a sorted sequence of len: the nearest rank.
  */
-void
-lsd_radix_sort_v2(vector<string> &elements, size_t max_width)
+static size_t
+quantile_index(double q, size_t len)
 {
-	constexpr int N = 256;
-	vector<string> aux;         // auxiliary vector of strings
-	array<int, N + 1> count;    // count of valid characters: one for each character.
-
-	/*
-	 * Repeat max_width times from least significant digit
-	 * (LSD) to most significant digit (MSD) sorting strings
-	 * based on the character at index w - 1.
-	 */
-	for (size_t w = max_width; w > 0; --w) {
-		// character index we are dealing with.
-		int idx = w - 1;
-
-		// copy all elements to the auxiliary vector.
-		for (auto e : elements)
-			aux.push_back(e);
-
-		// initialize all the counters to 0.
-		for (size_t c = 0; c <= N; ++c)
-			count[c] = 0;
-
-		/*
-		 * Set the count of each character. There is a trick here.
-		 * Instead of setting the count[char_at(a, idx)], it sets
-		 * count[char_at(a, idx) + 1].
-		 */
-		for (auto a : aux)
-			count[char_at(a, idx) + 1]++;
-
-		// Calculated the cumulative count.
-		for (size_t c = 0; c <= N; ++c)
-			count[c + 1] += count[c];
-
-		/*
-		 * Now count[char_at(a, idx)] represents the index where the
-		 * string should be copied into the main vector. count[char_at(a, idx)]
-		 * is incremented to represent the next index in case the character
-		 * is seen again.
-		 */
-		for (auto a : aux)
-			elements[count[char_at(a, idx)]++] = a;
-
-		aux.clear();
-
-#if defined(DEBUG)
-		cout << "w = " << w << " : " << elements << endl;
-#endif // DEBUG
-	}
-
-	return;
+	size_t rank = static_cast<size_t>(ceil(q * len));
+	return (rank > 0) ? rank - 1 : 0;
 }
 
 /*
- * MSD radix sort. The sort uses key index count sorting.
+ * Parse the argument of -kth: a comma separated list of indices, or of
+ * percentiles like p99.9 (the nearest rank in a sequence of len).
  *
- * @param [inout] elements  - the vector to sort.
- * @param [in]    aux       - an auxiliary vector.
- * @param [in]    lo        - process elements starting from lo index.
- * @param [in]    hi        - process elements upto hi index (non inclusive).
- * @param [in]    w         - position at which the character is to be processed.
- * @paran [in]    max_width - the maximum size of string across
- *                            all elements of the vector.
- * @return elements are sorted on return.
+ * @return false if an item is not valid.
  */
-static void
-msd_radix_sort(vector<string> &elements, vector<string> &aux, size_t lo, size_t hi, size_t w, size_t max_width)
+static bool
+parse_kth(const string &list, size_t len, vector<size_t> &ks)
 {
-	constexpr int N = 256;
-	array<int, N + 1> count;    // count of valid characters: one for each character <== trick
-	array<int, N> count2;       // count of valid characters: one for each character <== no trick
-
-	// have we scanned all the elements
-	if (w == max_width)
-		return;
-
-	// check if there is no elements or a single element to process.
-	if ((lo == hi) || ((lo + 1) == hi))
-		return;
-
-	// copy all elements to the auxiliary vector.
-	for (size_t i = lo; i < hi; ++i)
-		aux.push_back(elements[i]);
-
-	// initialize all the counters to 0.
-	for (size_t c = 0; c <= N; ++c)
-		count[c] = 0;
-
-	for (size_t c = 0; c < N; ++c)
-		count2[c] = 0;
-
-	/*
-	 * Set the count of each character. There is a trick here.
-	 * Instead of setting the count[char_at(a, idx)], it sets
-	 * count[char_at(a, idx) + 1].
-	 */
-	for (auto a : aux) {
-		int idx = char_at(a, w);
-		count[idx + 1]++;   // trick
-		count2[idx]++;      // no-trick
-	}
-
-	// set the cumulative count.
-	for (size_t c = 0; c < N; ++c)
-		count[c + 1] += count[c];
-
-	/*
-	 * Now lo + count[char_at(a, idx)] represents the index where the
-	 * string should be copied in the main vector. count[char_at(a, idx)]
-	 * is incremented to represent the next index in case the character
-	 * is seen again.
-	 */
-	for (auto a : aux)
-		elements[lo + count[char_at(a, w)]++] = a;
-
-	aux.clear();
-
-#if defined(DEBUG)
-	cout << "w = " << w + 1 << ", lo = " << lo << ", hi = " << hi << " : ";
-	for (size_t i = 0; i < elements.size(); ++i) {
-		if (i != 0)
-			cout << ", ";
-		if ((i < lo) || (i >= hi))
-			cout << "-";
-		else
-			cout << elements[i];
-	}
-	cout << endl;
-#endif // DEBUG
-
-	/*
-	 * The elements are now sorted based on character at position w.
-	 * Dive deep to sort elements at character position w + 1.
-	 * count2 tells us how many string to process.
-	 */
-	while (lo < hi) {
-		int num_of_elem = count2[char_at(elements[lo], w)];
-		msd_radix_sort(elements, aux, lo, lo + num_of_elem, w + 1, max_width);
-		lo += num_of_elem;
-	}
+	stringstream ss(list);
+	string item;
 
-	return;
-}
-
-/*
- * MSD radix sort.
- *
- * @param [inout] elements  - the vector to sort.
- * @paran [in]    max_width - the maximum size of string across
- *                            all elements of the vector.
- *
- * @return elements are sorted on return.
- */
-void
-msd_radix_sort(vector<string> &elements, size_t max_width)
-{
-	vector<string> aux;     // auxiliary vector of strings
-	msd_radix_sort(elements, aux, 0, elements.size(), 0, max_width);
-}
+	while (getline(ss, item, ',')) {
+		double q;
+		char *end;
 
-/*
- * Print statistics.
- */
-template<typename T>
-void
-print_stats(size_t iter, size_t ncmp, size_t nswap, const vector<T> &elements)
-{
-#if defined(DEBUG)
-	cout << "iteration = " << setw(2) << iter << " ( " <<  elements <<
-		" ) comparisons = " << setw(2) << ncmp << ", swap = " << setw(2) << nswap << endl;
-#endif
-}
+		if (item.empty() || (item[0] == '-'))
+			return false;
 
-/*
- * Perform bubble sort.
- *
- * @param [inout] elements  - the vector to sort.
- *
- * @return elements are sorted on return.
- */
-template<typename T>
-void
-bubble_sort(vector<T> &elements)
-{
-	size_t length = elements.size();
-	size_t ncmp;
-	size_t nswap;
-
-	for (size_t i = 0; i < length - 1; ++i) {
-		ncmp = 0;
-		nswap = 0;
-
-		for (size_t j = 0; j < length - i - 1; ++j) {
-			ncmp++;
-			if (elements[j] > elements[j + 1]) {
-				nswap++;
-				swap(elements[j], elements[j + 1]);
-			}
+		if (parse_percentile(item, q)) {
+			ks.push_back(quantile_index(q, len));
+		} else {
+			unsigned long long n = strtoull(item.c_str(), &end, 10);
+			if (*end != '\0')
+				return false;
+			ks.push_back(n);
 		}
-
-		print_stats(i + 1, ncmp, nswap, elements);
 	}
+
+	return !ks.empty();
 }
 
 /*
- * Perform selection sort.
- *
- * @param [inout] elements  - the vector to sort.
- *
- * @return elements are sorted on return.
+ * Parse the argument of -sketch: a comma separated list of percentiles.
  */
-template<typename T>
-void
-selection_sort(vector<T> &elements)
+static bool
+parse_quantiles(const string &list, vector<string> &names, vector<double> &qs)
 {
-	size_t ncmp;
-	size_t nswap;
-
-	for (size_t i = 0; i < elements.size() - 1; ++i) {
-		size_t min_idx = i;
-
-		ncmp = 0;
-		nswap = 0;
-
-		for (size_t j = i + 1; j < elements.size(); ++j) {
-			ncmp++;
-			if (elements[j] < elements[min_idx]) {
-				min_idx = j;
-			}
-		}
+	stringstream ss(list);
+	string item;
 
-		if (min_idx != i) {
-			nswap++;
-			swap(elements[i], elements[min_idx]);
-		}
+	while (getline(ss, item, ',')) {
+		double q;
 
-		print_stats(i + 1, ncmp, nswap, elements);
+		if (!parse_percentile(item, q))
+			return false;
+		names.push_back(item);
+		qs.push_back(q);
 	}
-}
 
-/*
- * Perform insertion sort.
- *
- * @param [inout] elements  - the vector to sort.
- *
- * @return elements are sorted on return.
- */
-template<typename T>
-void
-insertion_sort(vector<T> &elements)
-{
-	size_t ncmp;
-	size_t nswap;
-
-	/*
-	 * All items to the left of i are sorted and items
-	 * to the right of i, including i, are unsorted.
-	 */
-	for (size_t i = 1; i < elements.size(); ++i) {
-		ncmp = 0;
-		nswap = 0;
-
-		for (size_t j = i; j > 0; --j) {
-			ncmp++;
-			if (elements[j] < elements[j - 1]) {
-				nswap++;
-				swap(elements[j], elements[j - 1]);
-			} else {
-				/*
-				 * No point in proceeding further as the elements
-				 * to the left of index i are already sorted.
-				 */
-				break;
-			}
-		}
-
-		print_stats(i, ncmp, nswap, elements);
-	}
+	return !qs.empty();
 }
 
-/*
- * Print statistics.
- */
-template<typename T>
-void
-print_stats(size_t iter, size_t lo, size_t hi, size_t ncmp, size_t nmoves, const vector<T> &elements, bool copies = false)
+static bool
+sketch_block(kll_sketch<int> &sketch, const char *b, const char *e)
 {
-#if defined(DEBUG)
-	cout << "iteration = " << setw(2) << iter <<
-		", lo = " << setw(2) << lo << ", hi = " << setw(2) << hi <<
-		" ( " <<  elements << " ) comparisons = " << setw(2) << ncmp;
-	if (copies)
-		cout << ", copies = " << setw(2) << nmoves << endl;
-	else
-		cout << ", swaps = " << setw(2) << nmoves << endl;
-#endif
+	return scan_ints(b, e, [&](int v) { sketch.update(v); });
 }
 
-/*
- * Merge two sorted arrays: elements[lo, mid) and elements[mid, hi).
- * Items from elements[lo, hi) are first copied into an auxiliary array.
- * Items from auxiliary[lo, mid) and auxiliary[mid, hi) are then
- * merged back into the elements[lo, hi).
- *
- * @param [inout] elements  - the vector to sort.
- * @param [inout] auxiliary - the auxiliary vector to aid sorting.
- * @param [in]    lo        - the starting index.
- * @param [in]    mid       - the middle index.
- * @param [in]    hi        - the ending index (1 past the last item).
- *
- * @return elements[lo, hi) are merged correctly on return.
- */
-template<typename T>
-static void
-merge(vector<T> &elements, vector<T> &auxiliary, size_t lo, size_t mid, size_t hi, size_t iter)
+static bool
+sketch_block(kll_sketch<string> &sketch, const char *b, const char *e)
 {
-	if ((lo == mid) || (mid == hi)) {
-		// at least one of the sub-sequence is empty
-		return;
-	}
-
-	for (size_t k = lo; k < hi; ++k) {
-		// copy concerned elements to auxiliary vector
-		auxiliary[k] = elements[k];
-	}
-
-	size_t ncmp = 0;
-	size_t ncopy = 0;
-
-	size_t i = lo;
-	size_t j = mid;
-
-	if (auxiliary[mid - 1] < auxiliary[mid]) {
-		/*
-		 * Special case:
-		 * auxiliary[lo, mid) = ( 2, 3, 4, 5 )
-		 * auxiliary[mid, hi) = ( 7, 9, 10, 11 )
-		 * Nothing to do.
-		 */
-		ncmp++;
-	} else if (auxiliary[lo] > auxiliary[hi - 1]) {
-		/*
-		 * Special case:
-		 * auxiliary[lo, mid) = ( 7, 9, 10, 11 )
-		 * auxiliary[mid, hi) = ( 2, 3, 4, 5 )
-		 * First copy auxiliary[mid, hi), then copy auxiliary[lo, mid).
-		 */
-		ncmp++;
-		for (size_t k = mid; k < hi; ++k) {
-			ncopy++;
-			elements[i++] = auxiliary[k];
-		}
-		for (size_t k = lo; k < mid; ++k) {
-			ncopy++;
-			elements[i++] = auxiliary[k];
-		}
-	} else {
-		/*
-		 * Normal case:
-		 * Do normal comparison and pick element either from
-		 * auxiliary[lo, mid) or auxiliary[mid, hi).
-		 */
-		for (size_t k = lo; k < hi; ++k) {
-			ncopy++;
-			if (i >= mid) {
-				// all elements from auxiliary[lo, mid) are consumed
-				elements[k] = auxiliary[j++];
-			} else if (j >= hi) {
-				// all elements from auxiliary[mid, hi) are consumed
-				elements[k] = auxiliary[i++];
-			} else if (auxiliary[i] < auxiliary[j]) {
-				elements[k] = auxiliary[i++];
-				ncmp++;
-			} else {
-				elements[k] = auxiliary[j++];
-				ncmp++;
-			}
-		}
-	}
-
-	print_stats(iter, lo, hi, ncmp, ncopy, elements, true);
+	return scan_strings(b, e, [&](const char *p, const char *q) { sketch.update(string(p, q)); });
 }
 
-/*
- * Perform merge sort.
- *
- * @param [inout] elements  - the vector to sort.
- * @param [inout] auxiliary - the auxiliary vector to aid sorting.
- * @param [in]    lo        - the starting index.
- * @param [in]    ho        - the ending index (1 past the last item).
- * @param [in]    iter      - the iteration number.
- *
- * @return elements[lo, hi) are storted on return.
- */
-template<typename T>
-static void
-merge_sort_v1(vector<T> &elements, vector<T> &auxiliary, size_t lo, size_t hi, size_t &iter)
+static bool
+read_values(const input_file &in, vector<int> &values, size_t nthreads)
 {
-	if ((hi - lo) <= 1) {
-		// there is only one element left
-		return;
-	}
-
-	// get the partition point
-	size_t mid = (lo + hi) / 2;
-
-	// sort the lhs sequence
-	merge_sort_v1(elements, auxiliary, lo, mid, iter);
-
-	// sort the rhs sequence
-	merge_sort_v1(elements, auxiliary, mid, hi, iter);
-
-	// merge lhs & rhs
-	merge(elements, auxiliary, lo, mid, hi, iter++);
+	return read_ints(in, values, nthreads);
 }
 
-/*
- * Perform merge sort using recursion.
- *
- * @param [inout] elements  - the vector to sort.
- *
- * @return elements are sorted on return.
- */
-template<typename T>
-void
-merge_sort_v1(vector<T> &elements)
+static bool
+read_values(const input_file &in, vector<string> &values, size_t nthreads)
 {
-	// create an auxiliary sequence
-	vector<T> auxiliary(elements.size());
-
-	size_t iter = 1;
-
-	// make the recursive call
-	merge_sort_v1(elements, auxiliary, 0, elements.size(), iter);
+	return read_strings(in, values, nthreads);
 }
 
 /*
- * Perform merge sort without using recursion.
+ * Estimate quantiles of the file with a KLL sketch, streaming it through
+ * a block at a time, so that the input never has to fit in memory.
  *
- * @param [inout] elements  - the vector to sort.
+ * With exact, the file is also read into memory and the same quantiles
+ * are found with select_kth(). The rank error of every estimate (how far
+ * its rank is from the requested one, as a fraction of n) and both times
+ * are printed.
  *
- * @return elements are sorted on return.
- */
-template<typename T>
-void
-merge_sort_v2(vector<T> &elements)
-{
-	// create an auxiliary sequence
-	vector<T> auxiliary(elements.size());
-
-	size_t iter = 0;
-
-	/*
-	 * Keep doubling the merge size, starting with 1.
-	 * Do not use the stop condition as sz < elements.size() / 2.
-	 * This will work only if the number of elements are 2 * power(n).
-	 */
-	for (size_t sz = 1; sz < elements.size(); sz *= 2) {
-		size_t n = 2 * sz;
-
-		for (size_t lo = 0; lo < elements.size() - sz; lo += n) {
-			size_t mid = lo + sz;
-			size_t hi = lo + n;
-			if (hi > elements.size())
-				hi = elements.size();
-			merge(elements, auxiliary, lo, mid, hi, ++iter);
-		}
-	}
-}
-
-/*
- * Partitions the vector into two. The first element elements[lo] is the pivot element.
- * After partition, array[lo] is moved to its correct position. All the elements to
- * left of the pivot are less than array[lo] and all the elements to the right of
- * the pivot are greater than array[lo]. Returns the index of the pivot element position.
+ * @param [in]    file     - the input file.
+ * @param [in]    list     - the quantiles, e.g. p50,p99,p99.9.
+ * @param [in]    k        - the accuracy parameter of the sketch.
+ * @param [in]    exact    - whether to compare with select_kth().
+ * @param [in]    nthreads - threads for reading the file for select_kth().
  *
- * @param [inout] elements  - the input vector to partition.
- * @param [in]    lo        - the starting index.
- * @param [in]    hi        - the ending index.
- * @param [in]    iter      - the current iteration.
- *
- * @return the index of the pivot element after the vector is partitioned.
+ * @return the exit status.
  */
 template<typename T>
-size_t
-partition(vector<T> &elements, size_t lo, size_t hi, size_t iter)
+static int
+sketch_quantiles(const string &file, const string &list, size_t k, bool exact, size_t nthreads)
 {
-	size_t i = lo + 1;
-	size_t j = hi;
-
-	size_t ncmp = 0;
-	size_t nswap = 0;
-
-	while (i <= j) {
-		ncmp++;
-		if (elements[i] < elements[lo]) {
-			i++;
-		} else if (elements[j] > elements[lo]) {
-			j--;
-		} else {
-			swap(elements[i], elements[j]);
-			i++;
-			j--;
-			nswap++;
-		}
-	}
+	vector<string> names;
+	vector<double> qs;
+	kll_sketch<T> sketch(k);
 
-	if (lo != j) {
-		swap(elements[lo], elements[j]);
-		nswap++;
+	if (!parse_quantiles(list, names, qs)) {
+		cerr << "invalid argument for -sketch: " << list << endl;
+		return 1;
 	}
 
-	print_stats(iter, lo, hi, ncmp, nswap, elements);
-
-	return j;
-}
-
-/*
- * Select kth smallest element.
- *
- * @param [inout] elements - the input sequence.
- * @param [in]    k        - the kth smallest element to find.
- *
- * @return the kth smallest element.
- */
-template<typename T>
-T
-select_kth(vector<T> &elements, size_t k)
-{
-	size_t lo = 0;
-	size_t hi = elements.size() - 1;
-	size_t iter = 0;
+	chrono::time_point<chrono::high_resolution_clock> start = chrono::high_resolution_clock::now();
 
-	while (lo <= hi) {
-		size_t p = partition(elements, lo, hi, ++iter);
-		if (p == k)
-			break;
-		else if (p < k)
-			lo = p + 1;
-		else
-			hi = p - 1;
+	if (!scan_file(file, [&](const char *b, const char *e) { return sketch_block(sketch, b, e); })) {
+		cerr << "cannot read " << file << ", or invalid input in it" << endl;
+		return 1;
 	}
 
-	return elements[k];
-}
-
-/*
- * Partitions the vector into three. The first element elements[lo] is the pivot element.
- * There may be multiple occurrence of the pivot element. After partition, the vector
- * is divided into 3 segments: 1st segment with elements less than pivot element,
- * 2nd segement with all pivot elements(s), and 3rd segment with all elements greater
- * than pivot element.
- *
- * @param [inout] elements  - the input vector to partition.
- * @param [in]    lo        - the starting index.
- * @param [in]    hi        - the ending index.
- * @param [out]   p1        - the stating index of the pivot element.
- * @param [out]   p2        - the ending index of the pivot element.
- * @param [in]    iter      - the current iteration.
- *
- */
-template<typename T>
-void
-partition(vector<T> &elements, size_t lo, size_t hi, size_t &p1, size_t &p2, size_t iter)
-{
-	size_t ncmp = 0;
-	size_t nswap = 0;
-
-	size_t i = lo + 1;
-
-	p1 = lo;
-	p2 = hi;
-
-	while (i <= p2) {
-		ncmp++;
-		if (elements[i] < elements[p1]) {
-			swap(elements[i], elements[p1]);
-			i++;
-			p1++;
-			nswap++;
-		} else if (elements[i] == elements[p1]) {
-			i++;
-		} else /* if (elements[i] > elements[p1]) */ {
-			swap(elements[i], elements[p2]);
-			// Do not increment i, the new element at i could still be greater than pivot
-			p2--;
-			nswap++;
-		}
+	if (sketch.count() == 0) {
+		cerr << "empty sequence" << endl;
+		return 1;
 	}
 
-	print_stats(iter, lo, hi, ncmp, nswap, elements);
-}
-
-/**
- * Quick Sort. Consider shuffling the items if the sequence is not randomly
- * distributed. Find a pivot element and move it to its correct location
- * using partition(). Recursively sort the first half and the second half.
- *
- * @param [inout] elements  - the vector to sort.
- * @param [in]    lo        - the starting index.
- * @param [in]    hi        - the ending index.
- * @param [in]    iter      - the current iteration.
- *
- * @return elements are sorted on return.
- */
-template<typename T>
-void
-quick_sort_v1(vector<T> &elements, size_t lo, size_t hi, size_t &iter)
-{
-	if (lo >= hi)
-		return;
+	vector<T> estimates = sketch.quantiles(qs);
 
-	size_t p = partition(elements, lo, hi, ++iter);
-
-	if (p > lo)
-		quick_sort_v1(elements, lo, p - 1, iter);
-
-	if (p < hi)
-		quick_sort_v1(elements, p + 1, hi, iter);
-}
-
-/*
- * Perform quick sort.
- *
- * @param [inout] elements  - the vector to sort.
- *
- * @return elements are sorted on return.
- */
-template<typename T>
-void
-quick_sort_v1(vector<T> &elements)
-{
-	if (elements.empty())
-		return;
-
-	size_t iter = 0;
-
-	quick_sort_v1(elements, 0, elements.size() - 1, iter);
-}
-
-/**
- * 3-way quick sort.
- *
- * @param [inout] elements  - the vector to sort.
- * @param [in]    lo        - the starting index.
- * @param [in]    hi        - the ending index.
- * @param [in]    iter      - the current iteration.
- *
- * @return elements are sorted on return.
- */
-template<typename T>
-void
-quick_sort_v2(vector<T> &elements, size_t lo, size_t hi, size_t &iter)
-{
-	size_t p1, p2;
-
-	if (lo >= hi)
-		return;
-
-	partition(elements, lo, hi, p1, p2, ++iter);
-
-	if (p1 > lo)
-		quick_sort_v2(elements, lo, p1 - 1, iter);
+	chrono::time_point<chrono::high_resolution_clock> stop = chrono::high_resolution_clock::now();
+	int64_t sketch_us = chrono::duration_cast<chrono::microseconds>(stop - start).count();
 
-	if (p2 < hi)
-		quick_sort_v2(elements, p2 + 1, hi, iter);
-}
+	if (!exact) {
+		for (size_t i = 0; i < qs.size(); ++i)
+			cout << names[i] << ": " << estimates[i] << endl;
+	} else {
+		input_file fin(file);
+		vector<T> values;
 
-/*
- * Perform quick sort.
- *
- * @param [inout] elements  - the vector to sort.
- *
- * @return elements are sorted on return.
- */
-template<typename T>
-void
-quick_sort_v2(vector<T> &elements)
-{
-	if (elements.empty())
-		return;
+		if (!fin.ok() || !read_values(fin, values, nthreads)) {
+			cerr << "cannot read " << file << ", or invalid input in it" << endl;
+			return 1;
+		}
 
-	size_t iter = 0;
+		size_t n = values.size();
+		vector<size_t> ks;
+
+		for (double q : qs)
+			ks.push_back(quantile_index(q, n));
+
+		start = chrono::high_resolution_clock::now();
+		vector<T> exacts = select_kth(values, ks);
+		stop = chrono::high_resolution_clock::now();
+		int64_t select_us = chrono::duration_cast<chrono::microseconds>(stop - start).count();
+
+		for (size_t i = 0; i < qs.size(); ++i) {
+			/*
+			 * The estimate holds ranks (lo, hi] of the sorted values.
+			 */
+			size_t lo = 0;
+			size_t hi = 0;
+			for (const T &v : values) {
+				lo += (v < estimates[i]);
+				hi += !(estimates[i] < v);
+			}
 
-	quick_sort_v2(elements, 0, elements.size() - 1, iter);
-}
+			size_t rank = ks[i] + 1;
+			size_t off = (rank <= lo) ? lo + 1 - rank : ((rank > hi) ? rank - hi : 0);
 
-/*
- * Percolates an element down to its correct location in the heap.
- * We are dealing with maximum heap.
- *
- * @param [inout] elements - the vector to fix.
- * @param [in]    n        - the size of the vector. Do not rely on elements.size().
- * @param [in]    i        - the element index that needs to be moved, if needed.
- * @param [in]    iter     - the current iteration.
- * @param [in]    incrswap - the flag to increment swap count by 1.
- */ 
-template<typename T>
-static void
-heap_sink(vector<T> &elements, int n, int i, size_t iter, bool incrswap = false)
-{
-	size_t ncmp = 0;
-	size_t nswap = incrswap ? 1 : 0;
-
-	if (n <= 1)
-		return;
-
-	while (i < n) {
-		int l = 2 * i + 1;
-		int r = 2 * i + 2;
-		int c;
-
-		if (l >= n) {
-			c = r;
-		} else if (r >= n) {
-			c = l;
-		} else if (elements[l] > elements[r]) {
-			c = l;
-			ncmp++;
-		} else {
-			c = r;
-			ncmp++;
+			cout << names[i] << ": " << estimates[i] << " (exact " << exacts[i]
+				<< ", rank error " << fixed << setprecision(4)
+				<< static_cast<double>(off) / n << ")" << endl;
 		}
 
-		if ((c < n) && (elements[c] > elements[i])) {
-			swap(elements[c], elements[i]);
-			i = c;
-			ncmp++;
-			nswap++;
-		} else {
-			break;
-		}
+		cout << "select_kth: " << select_us << " us" << endl;
 	}
 
-	print_stats(iter, ncmp, nswap, elements);
-}
-
-/*
- * Perform heap sort.
- *
- * @param [inout] elements  - the vector to sort.
- *
- * @return elements are sorted on return.
- */
-template<typename T>
-static void
-heap_sort(vector<T> &elements)
-{
-	if (elements.empty())
-		return;
-
-	size_t iter = 0;
-
-#if defined(DEBUG)
-	cout << "----- build heap -----" << endl;
-#endif
+	cout << "n = " << sketch.count() << ", kept " << sketch.size() << " items, rank error <= "
+		<< fixed << setprecision(4) << sketch.rank_error() << " (99% confidence)" << endl;
+	cout << "sketch: " << sketch_us << " us" << endl;
 
-	/*
-	 * Change the vector into a maximum heap.
-	 */
-	int n = static_cast<int>(elements.size());
-	for (int i = n / 2 - 1; i >= 0; --i)
-		heap_sink(elements, n, i, ++iter, false);
-
-#if defined(DEBUG)
-	cout << "----- heap ready -----" << endl;
-#endif
-
-	for (int i = n - 1; i > 0; --i) {
-		/* Swap the fist (largest) element with the last element */
-		swap(elements[0], elements[i]);
-
-		/*
-		 * Fix the heap again assuming the heap size is 1 less.
-		 * Notice i is passed as the heap size and not n.
-		 */
-		heap_sink(elements, i, 0, ++iter, true);
-	}
+	return 0;
 }
 
 static int
 usage(const char *progname)
 {
-	cerr << progname << " -in <file> [-string]" << endl
+	cerr << progname << " -in <file> [-string | -binary] [-quiet] [-stats]" << endl
+		<< "    -stats                      Count comparisons, swaps and copies (bubble, selection," << endl
+		<< "                                insertion, merge_v1, merge_v2, quick_v1, quick_v2, heap)." << endl
+		<< "    -string                     The input is whitespace separated strings (default integers)." << endl
+		<< "    -binary                     The input is 32-bit integers in native byte order." << endl
 		<< "    -lsd_radix_v1               Perform LSD radix sort (using queues)." << endl
 		<< "    -lsd_radix_v2               Perform LSD radix sort (using key index count)." << endl
+		<< "    -lsd_radix_v3               Perform LSD radix sort (on string indices, no copies)." << endl
 		<< "    -msd_radix                  Perform MSD radix sort." << endl
+		<< "    -msd_radix_v2               Perform hybrid MSD radix sort (in place, multikey quicksort cutover)." << endl
+		<< "    -lsd_radix_int [-digit <b>] [-threads <n>]" << endl
+		<< "                                Perform LSD radix sort on integers (b-bit digits, default 8;" << endl
+		<< "                                n threads, default one per core)." << endl
 		<< "    -bubble                     Perform bubble sort." << endl
 		<< "    -selection                  Perform selection sort." << endl
 		<< "    -insertion                  Perform insertion sort." << endl
 		<< "    -merge_v1                   Perform merge sort recursively." << endl
 		<< "    -merge_v2                   Perform merge sort non-recursively." << endl
-		<< "    -kth <item>                 Find k-th smallest item." << endl
+		<< "    -merge_parallel [-threads <n>]" << endl
+		<< "                                Perform parallel merge sort (n threads, default one per core)." << endl
+		<< "    -merge_power                Perform powersort (adaptive natural merge sort)." << endl
+		<< "    -kth <k>[,<k>...]           Find the k-th smallest items; k is an index or a percentile" << endl
+		<< "                                like p99.9." << endl
 		<< "    -quick_v1                   Perform basic quick sort." << endl
 		<< "    -quick_v2                   Perform 3-way quick sort." << endl
-		<< "    -heap                       Perform heap sort." << endl;
+		<< "    -intro                      Perform intro sort (quick sort with heap sort fallback)." << endl
+		<< "    -sample [-threads <n>]      Perform parallel sample sort (n threads, default one per core)." << endl
+		<< "    -heap                       Perform heap sort." << endl
+		<< "    -dary_heap [-arity <d>]     Perform heap sort on a d-ary heap with bottom-up sinks" << endl
+		<< "                                (d = 2, 4 or 8, default 4)." << endl
+		<< "    -argsort [-engine <radix|quick>]" << endl
+		<< "                                Sort (key, index) pairs, then move the values in place" << endl
+		<< "                                (default radix for integers, quick for strings)." << endl
+		<< "    -std                        Perform std::sort (for comparison)." << endl
+		<< "    -external [-mem <MB>] [-out <file>] [-tmp <dir>] [-threads <n>]" << endl
+		<< "                                Perform external merge sort within mem MB (default 1024)," << endl
+		<< "                                spilling runs to dir (default $TMPDIR or /tmp) and writing" << endl
+		<< "                                one value per line to file (default stdout, none if -quiet)." << endl
+		<< "    -sketch <pX>[,<pX>...] [-sketch_k <k>] [-exact]" << endl
+		<< "                                Estimate percentiles with a KLL sketch (accuracy k, default" << endl
+		<< "                                200), streaming the input; -exact compares with -kth." << endl
+		<< "    -simd <none|sse4|avx2>      Highest instruction set for the int kernels (default avx2)." << endl;
 	return 1;
 }
 
@@ -952,28 +276,103 @@ enum sort_algo
 	NONE,
 	LSD_RADIX_V1,
 	LSD_RADIX_V2,
+	LSD_RADIX_V3,
 	MSD_RADIX,
+	MSD_RADIX_V2,
+	LSD_RADIX_INT,
 	BUBBLE,
 	SELECTION,
 	INSERTION,
 	MERGE_V1,
 	MERGE_V2,
+	MERGE_PARALLEL,
+	MERGE_POWER,
 	KTH,
 	QUICK_V1,
 	QUICK_V2,
-	HEAP
+	INTRO,
+	SAMPLE,
+	HEAP,
+	DARY_HEAP,
+	ARGSORT,
+	STD_SORT,
+	EXTERNAL,
+	SKETCH
 };
 
+/*
+ * Run one of the sorts that report to an instrumentation policy.
+ *
+ * @param [in]    algo      - the sort.
+ * @param [inout] elements  - the vector to sort.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return false if algo does not take a policy.
+ */
+template<typename T, typename S>
+static bool
+instrumented_sort(sort_algo algo, vector<T> &elements, S &stats)
+{
+	switch (algo) {
+		case BUBBLE:
+			bubble_sort(elements, stats);
+			return true;
+
+		case SELECTION:
+			selection_sort(elements, stats);
+			return true;
+
+		case INSERTION:
+			insertion_sort(elements, stats);
+			return true;
+
+		case MERGE_V1:
+			merge_sort_v1(elements, stats);
+			return true;
+
+		case MERGE_V2:
+			merge_sort_v2(elements, stats);
+			return true;
+
+		case QUICK_V1:
+			quick_sort_v1(elements, stats);
+			return true;
+
+		case QUICK_V2:
+			quick_sort_v2(elements, stats);
+			return true;
+
+		case HEAP:
+			heap_sort(elements, stats);
+			return true;
+
+		default:
+			return false;
+	}
+}
+
 int
 main(int argc, const char **argv)
 {
 	sort_algo       algo = NONE;
 	string          file;
-	string          tmpstr;
-	int             tmpval = -1;
-	size_t          k = -1;
+	string          kth_list;
+	vector<size_t>  ks;
+	string          sketch_list;
+	size_t          sketch_k = 200;
+	bool            exact = false;
+	bool            count_stats = false;
+	counting_stats  counter;
 	size_t          len = 0;
+	unsigned        digit_bits = 8;
+	unsigned        arity = 4;
+	key_engine      engine = KEY_AUTO;
+	size_t          nthreads = 0;
+	size_t          mem_mb = 1024;
+	string          outfile;
+	string          tmpdir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
 	bool            is_string = false;
+	bool            binary = false;
 	bool            quiet = false;
 	vector<int>     ivalues;
 	vector<string>  svalues;
@@ -989,14 +388,37 @@ main(int argc, const char **argv)
 			}
 		} else if (strcmp(argv[i], "-string") == 0) {
 			is_string = true;
+		} else if (strcmp(argv[i], "-binary") == 0) {
+			binary = true;
 		} else if (strcmp(argv[i], "-quiet") == 0) {
 			quiet = true;
+		} else if (strcmp(argv[i], "-stats") == 0) {
+			count_stats = true;
 		} else if (strcmp(argv[i], "-lsd_radix_v1") == 0) {
 			algo = LSD_RADIX_V1;
 		} else if (strcmp(argv[i], "-lsd_radix_v2") == 0) {
 			algo = LSD_RADIX_V2;
+		} else if (strcmp(argv[i], "-lsd_radix_v3") == 0) {
+			algo = LSD_RADIX_V3;
 		} else if (strcmp(argv[i], "-msd_radix") == 0) {
 			algo = MSD_RADIX;
+		} else if (strcmp(argv[i], "-msd_radix_v2") == 0) {
+			algo = MSD_RADIX_V2;
+		} else if (strcmp(argv[i], "-lsd_radix_int") == 0) {
+			algo = LSD_RADIX_INT;
+		} else if (strcmp(argv[i], "-digit") == 0) {
+			i++;
+			if (argv[i]) {
+				int n = atoi(argv[i]);
+				if ((n < 1) || (n > 16)) {
+					cerr << "invalid argument for " << argv[i - 1] << endl;
+					return 1;
+				}
+				digit_bits = n;
+			} else {
+				cerr << "missing argument for " << argv[i - 1] << endl;
+				return 1;
+			}
 		} else if (strcmp(argv[i], "-bubble") == 0) {
 			algo = BUBBLE;
 		} else if (strcmp(argv[i], "-selection") == 0) {
@@ -1007,16 +429,43 @@ main(int argc, const char **argv)
 			algo = MERGE_V1;
 		} else if (strcmp(argv[i], "-merge_v2") == 0) {
 			algo = MERGE_V2;
-		} else if (strcmp(argv[i], "-kth") == 0) {
-			algo = KTH;
+		} else if (strcmp(argv[i], "-merge_parallel") == 0) {
+			algo = MERGE_PARALLEL;
+		} else if (strcmp(argv[i], "-merge_power") == 0) {
+			algo = MERGE_POWER;
+		} else if (strcmp(argv[i], "-threads") == 0) {
 			i++;
 			if (argv[i]) {
 				int n = atoi(argv[i]);
-				if (n < 0) {
+				if (n < 1) {
 					cerr << "invalid argument for " << argv[i - 1] << endl;
 					return 1;
 				}
-				k = n;
+				nthreads = n;
+			} else {
+				cerr << "missing argument for " << argv[i - 1] << endl;
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-simd") == 0) {
+			i++;
+			if (argv[i] == nullptr) {
+				cerr << "missing argument for " << argv[i - 1] << endl;
+				return 1;
+			} else if (strcmp(argv[i], "none") == 0) {
+				simd_limit(SIMD_NONE);
+			} else if (strcmp(argv[i], "sse4") == 0) {
+				simd_limit(SIMD_SSE4);
+			} else if (strcmp(argv[i], "avx2") == 0) {
+				simd_limit(SIMD_AVX2);
+			} else {
+				cerr << "invalid argument for " << argv[i - 1] << endl;
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-kth") == 0) {
+			algo = KTH;
+			i++;
+			if (argv[i]) {
+				kth_list = argv[i];
 			} else {
 				cerr << "missing argument for " << argv[i - 1] << endl;
 				return 1;
@@ -1025,8 +474,99 @@ main(int argc, const char **argv)
 			algo = QUICK_V1;
 		} else if (strcmp(argv[i], "-quick_v2") == 0) {
 			algo = QUICK_V2;
+		} else if (strcmp(argv[i], "-intro") == 0) {
+			algo = INTRO;
+		} else if (strcmp(argv[i], "-sample") == 0) {
+			algo = SAMPLE;
 		} else if (strcmp(argv[i], "-heap") == 0) {
 			algo = HEAP;
+		} else if (strcmp(argv[i], "-dary_heap") == 0) {
+			algo = DARY_HEAP;
+		} else if (strcmp(argv[i], "-arity") == 0) {
+			i++;
+			if (argv[i]) {
+				int n = atoi(argv[i]);
+				if ((n != 2) && (n != 4) && (n != 8)) {
+					cerr << "invalid argument for " << argv[i - 1] << endl;
+					return 1;
+				}
+				arity = n;
+			} else {
+				cerr << "missing argument for " << argv[i - 1] << endl;
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-argsort") == 0) {
+			algo = ARGSORT;
+		} else if (strcmp(argv[i], "-engine") == 0) {
+			i++;
+			if (argv[i] == nullptr) {
+				cerr << "missing argument for " << argv[i - 1] << endl;
+				return 1;
+			} else if (strcmp(argv[i], "radix") == 0) {
+				engine = KEY_RADIX;
+			} else if (strcmp(argv[i], "quick") == 0) {
+				engine = KEY_QUICK;
+			} else {
+				cerr << "invalid argument for " << argv[i - 1] << endl;
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-std") == 0) {
+			algo = STD_SORT;
+		} else if (strcmp(argv[i], "-sketch") == 0) {
+			algo = SKETCH;
+			i++;
+			if (argv[i]) {
+				sketch_list = argv[i];
+			} else {
+				cerr << "missing argument for " << argv[i - 1] << endl;
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-sketch_k") == 0) {
+			i++;
+			if (argv[i]) {
+				int n = atoi(argv[i]);
+				if (n < 8) {
+					cerr << "invalid argument for " << argv[i - 1] << endl;
+					return 1;
+				}
+				sketch_k = n;
+			} else {
+				cerr << "missing argument for " << argv[i - 1] << endl;
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-exact") == 0) {
+			exact = true;
+		} else if (strcmp(argv[i], "-external") == 0) {
+			algo = EXTERNAL;
+		} else if (strcmp(argv[i], "-mem") == 0) {
+			i++;
+			if (argv[i]) {
+				int n = atoi(argv[i]);
+				if (n < 1) {
+					cerr << "invalid argument for " << argv[i - 1] << endl;
+					return 1;
+				}
+				mem_mb = n;
+			} else {
+				cerr << "missing argument for " << argv[i - 1] << endl;
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-out") == 0) {
+			i++;
+			if (argv[i]) {
+				outfile = argv[i];
+			} else {
+				cerr << "missing argument for " << argv[i - 1] << endl;
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-tmp") == 0) {
+			i++;
+			if (argv[i]) {
+				tmpdir = argv[i];
+			} else {
+				cerr << "missing argument for " << argv[i - 1] << endl;
+				return 1;
+			}
 		} else {
 			return usage(argv[0]);
 		}
@@ -1042,55 +582,131 @@ main(int argc, const char **argv)
 		return usage(argv[0]);
 	}
 
-	size_t max_width = 0;
+	if (count_stats && (algo != BUBBLE) && (algo != SELECTION) && (algo != INSERTION) &&
+	    (algo != MERGE_V1) && (algo != MERGE_V2) && (algo != QUICK_V1) && (algo != QUICK_V2) && (algo != HEAP)) {
+		cerr << "-stats is not supported by this sorting algorithm." << endl;
+		return usage(argv[0]);
+	}
 
-	fstream fin(file, ios_base::in);
-	while (fin) {
-		if (is_string) {
-			fin >> tmpstr;
-			if (!tmpstr.empty()) {
-				max_width = max(max_width, tmpstr.length());
-				svalues.push_back(tmpstr);
-				tmpstr.clear();
-			}
-		} else {
-			fin >> tmpval;
-			if (tmpval != -1) {
-				ivalues.push_back(tmpval);
-				tmpval = -1;
+	if (binary && (is_string || (algo == EXTERNAL) || (algo == SKETCH))) {
+		cerr << "-binary is only supported for integers held in memory." << endl;
+		return usage(argv[0]);
+	}
+
+	if (algo == SKETCH) {
+		if (is_string)
+			return sketch_quantiles<string>(file, sketch_list, sketch_k, exact, nthreads);
+		else
+			return sketch_quantiles<int>(file, sketch_list, sketch_k, exact, nthreads);
+	}
+
+	if (algo == EXTERNAL) {
+		/*
+		 * The input does not have to fit in memory: it is streamed
+		 * through the run files to the output, not read into a vector.
+		 */
+		FILE *fout = nullptr;
+
+		if (!outfile.empty()) {
+			fout = fopen(outfile.c_str(), "w");
+			if (fout == nullptr) {
+				cerr << "cannot open " << outfile << endl;
+				return 1;
 			}
+		} else if (!quiet) {
+			fout = stdout;
 		}
+
+		chrono::time_point<chrono::high_resolution_clock> start = chrono::high_resolution_clock::now();
+
+		try {
+			if (is_string)
+				external_sort<string>(file, fout, mem_mb << 20, nthreads, tmpdir);
+			else
+				external_sort<int>(file, fout, mem_mb << 20, nthreads, tmpdir);
+		} catch (const exception &e) {
+			cerr << e.what() << endl;
+			return 1;
+		}
+
+		chrono::time_point<chrono::high_resolution_clock> stop = chrono::high_resolution_clock::now();
+
+		if ((fout != nullptr) && (fout != stdout))
+			fclose(fout);
+
+		cout << chrono::duration_cast<chrono::microseconds>(stop - start).count() << endl;
+
+		return 0;
+	}
+
+	size_t max_width = 0;
+	bool parsed;
+
+	input_file fin(file);
+	if (!fin.ok()) {
+		cerr << "cannot read " << file << endl;
+		return 1;
 	}
-	fin.close();
+
+	if (is_string)
+		parsed = read_strings(fin, svalues, nthreads);
+	else if (binary)
+		parsed = read_binary_ints(fin, ivalues);
+	else
+		parsed = read_ints(fin, ivalues, nthreads);
+
+	if (!parsed) {
+		cerr << "invalid input in " << file << endl;
+		return 1;
+	}
+
+	for (const string &s : svalues)
+		max_width = max(max_width, s.length());
+
+	len = is_string ? svalues.size() : ivalues.size();
 
 	if (!quiet) {
 		cout << "input : ";
-		if (is_string) {
-			len = svalues.size();
+		if (is_string)
 			cout << svalues;
-		} else {
-			len = ivalues.size();
+		else
 			cout << ivalues;
-		}
 		cout << endl;
 	}
 
 
 	if (algo == KTH) {
-		if (k >= len) {
-			cerr << "kth value, " << k << ", is beyond range, " << len << endl;
+		if (len == 0) {
+			cerr << "empty sequence" << endl;
 			return 1;
 		}
 
-		if (len == 0) {
-			cerr << "empty sequence" << endl;
+		if (!parse_kth(kth_list, len, ks)) {
+			cerr << "invalid argument for -kth: " << kth_list << endl;
 			return 1;
 		}
 
-		if (is_string)
-			cout << select_kth(svalues, k) << endl;
-		else
-			cout << select_kth(ivalues, k) << endl;
+		for (size_t k : ks) {
+			if (k >= len) {
+				cerr << "kth value, " << k << ", is beyond range, " << len << endl;
+				return 1;
+			}
+		}
+
+		if (ks.size() == 1) {
+			if (is_string)
+				cout << select_kth(svalues, ks[0]) << endl;
+			else
+				cout << select_kth(ivalues, ks[0]) << endl;
+		} else {
+			if (is_string) {
+				for (const string &v : select_kth(svalues, ks))
+					cout << v << endl;
+			} else {
+				for (int v : select_kth(ivalues, ks))
+					cout << v << endl;
+			}
+		}
 
 		return 0;
 	}
@@ -1100,18 +716,25 @@ main(int argc, const char **argv)
 	switch (algo) {
 		case LSD_RADIX_V1:
 			if (!is_string)
-				cerr << "LSD radix sort is applicable to strings only." << endl;
+				cerr << "LSD radix sort is applicable to strings only; use -lsd_radix_int for integers." << endl;
 			else
 				lsd_radix_sort_v1(svalues, max_width);
 			break;
 
 		case LSD_RADIX_V2:
 			if (!is_string)
-				cerr << "LSD radix sort is applicable to strings only." << endl;
+				cerr << "LSD radix sort is applicable to strings only; use -lsd_radix_int for integers." << endl;
 			else
 				lsd_radix_sort_v2(svalues, max_width);
 			break;
 
+		case LSD_RADIX_V3:
+			if (!is_string)
+				cerr << "LSD radix sort is applicable to strings only; use -lsd_radix_int for integers." << endl;
+			else
+				lsd_radix_sort_v3(svalues, max_width);
+			break;
+
 		case MSD_RADIX:
 			if (!is_string)
 				cerr << "MSD radix sort is applicable to strings only." << endl;
@@ -1119,60 +742,89 @@ main(int argc, const char **argv)
 				msd_radix_sort(svalues, max_width);
 			break;
 
-		case BUBBLE:
+		case MSD_RADIX_V2:
+			if (!is_string)
+				cerr << "MSD radix sort is applicable to strings only." << endl;
+			else
+				msd_radix_sort_v2(svalues);
+			break;
+
+		case LSD_RADIX_INT:
 			if (is_string)
-				bubble_sort(svalues);
+				cerr << "-lsd_radix_int is applicable to integers only." << endl;
 			else
-				bubble_sort(ivalues);
+				lsd_radix_sort(ivalues, digit_bits, nthreads);
 			break;
 
+		case BUBBLE:
 		case SELECTION:
+		case INSERTION:
+		case MERGE_V1:
+		case MERGE_V2:
+		case QUICK_V1:
+		case QUICK_V2:
+		case HEAP:
+			if (count_stats) {
+				if (is_string)
+					instrumented_sort(algo, svalues, counter);
+				else
+					instrumented_sort(algo, ivalues, counter);
+			} else {
+				sort_stats stats;
+				if (is_string)
+					instrumented_sort(algo, svalues, stats);
+				else
+					instrumented_sort(algo, ivalues, stats);
+			}
+			break;
+
+		case MERGE_PARALLEL:
 			if (is_string)
-				selection_sort(svalues);
+				parallel_merge_sort(svalues, nthreads);
 			else
-				selection_sort(ivalues);
+				parallel_merge_sort(ivalues, nthreads);
 			break;
 
-		case INSERTION:
+		case MERGE_POWER:
 			if (is_string)
-				insertion_sort(svalues);
+				power_sort(svalues);
 			else
-				insertion_sort(ivalues);
+				power_sort(ivalues);
 			break;
 
-		case MERGE_V1:
+		case INTRO:
 			if (is_string)
-				merge_sort_v1(svalues);
+				intro_sort(svalues);
 			else
-				merge_sort_v1(ivalues);
+				intro_sort(ivalues);
 			break;
 
-		case MERGE_V2:
+		case SAMPLE:
 			if (is_string)
-				merge_sort_v2(svalues);
+				parallel_sample_sort(svalues, nthreads);
 			else
-				merge_sort_v2(ivalues);
+				parallel_sample_sort(ivalues, nthreads);
 			break;
 
-		case QUICK_V1:
+		case DARY_HEAP:
 			if (is_string)
-				quick_sort_v1(svalues);
+				dary_heap_sort(svalues, arity);
 			else
-				quick_sort_v1(ivalues);
+				dary_heap_sort(ivalues, arity);
 			break;
 
-		case QUICK_V2:
+		case ARGSORT:
 			if (is_string)
-				quick_sort_v2(svalues);
+				sort_by_key(svalues, [](const string &v) -> const string & { return v; }, engine);
 			else
-				quick_sort_v2(ivalues);
+				sort_by_key(ivalues, [](int v) { return v; }, engine);
 			break;
 
-		case HEAP:
+		case STD_SORT:
 			if (is_string)
-				heap_sort(svalues);
+				sort(svalues.begin(), svalues.end());
 			else
-				heap_sort(ivalues);
+				sort(ivalues.begin(), ivalues.end());
 			break;
 
 		default:
@@ -1190,6 +842,13 @@ main(int argc, const char **argv)
 		cout << endl;
 	}
 
+	if (count_stats) {
+		if (is_string)
+			counter.report(cout, len, sizeof(string));
+		else
+			counter.report(cout, len, sizeof(int));
+	}
+
 	cout << chrono::duration_cast<chrono::microseconds>(stop - start).count() << endl;
 
 	return 0;
@@ -0,0 +1,1814 @@
+#if !defined(SORT_H_)
+#define SORT_H_
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <queue>
+#include <array>
+#include <string>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include "radix.h"
+#include "parallel.h"
+#include "partition.h"
+#include "kway.h"
+#include "simd.h"
+#include "stats.h"
+
+using namespace std;
+
+template<typename T>
+static ostream &
+operator<< (ostream &os, const queue<T> &values)
+{
+	bool first = true;
+	queue<T> tmpq(values);
+
+	while (!tmpq.empty()) {
+		if (!first) {
+			os << ", ";	
+		} else {
+			first = false;
+		}
+		os << tmpq.front();
+		tmpq.pop();
+	}
+	return os;
+}
+
+/*
+ * Get the character at the specified index in the
+ * given string.
+ *
+ * @param [in] s - the given string.
+ * @param [in] i - the given index.
+ *
+ * @return character at the specified index in the string.
+ * If the index is beyond the string length, return 0.
+ */
+inline int
+char_at(const std::string &s, size_t i)
+{
+	return (i < s.length()) ? s[i] : 0;
+}
+
+/*
+ * LSD radix sort. This is a straight-forward  implementation
+ * using:
+ * - 1 main queue, initialized with input items.
+ * - 256 auxiliary queues, one for every possible character [0-255].
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @paran [in]    max_width - the maximum size of string across
+ *                            all elements of the vector.
+ *
+ * @return elements are sorted on return.
+ */
+inline void
+lsd_radix_sort_v1(vector<string> &elements, size_t max_width)
+{
+	constexpr int N = 256;
+	queue<string> mainq;
+
+	/*
+	 * 256 auxiliary queues: one for each valid character.
+	 */
+	array<queue<string>, N> auxq;
+
+	/*
+	 * Move all the strings to the main queue.
+	 * This queue is processed (sorted) at every valid
+	 * index position.
+	 */
+	for (auto e : elements)
+		mainq.push(e);
+	elements.clear();
+
+	/*
+	 * Repeat max_width times from least significant digit
+	 * (LSD) to most significant digit (MSD) sorting strings
+	 * based on the character at index w - 1.
+	 */
+	for (size_t w = max_width; w > 0; --w) {
+		/*
+		 * Read the strings from the main queue and
+		 * push the strings in the correct queue.
+		 */
+		while (!mainq.empty()) {
+			string s = mainq.front();
+			mainq.pop();
+			auxq[char_at(s, w - 1)].push(s);
+		}
+
+		/*
+		 * Copy the strings back from auxiliary queues
+		 * to the main queue.
+		 */
+		for (size_t j = 0; j < N; ++j) {
+			while (!auxq[j].empty()) {
+				mainq.push(auxq[j].front());
+				auxq[j].pop();
+			}
+		}
+
+#if defined(DEBUG)
+		cout << "w = " << w << " : " << mainq << endl;
+#endif // DEBUG
+	}
+
+	/*
+	 * The main queue is sorted now!
+	 * Copy the strings from the main queue back to the
+	 * vector.
+	 */
+	while (!mainq.empty()) {
+		elements.push_back(mainq.front());
+		mainq.pop();
+	}
+
+	return;
+}
+
+/*
+ * LSD radix sort. The sort uses key index count sorting.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @paran [in]    max_width - the maximum size of string across
+ *                            all elements of the vector.
+ *
+ * @return elements are sorted on return.
+ */
+inline void
+lsd_radix_sort_v2(vector<string> &elements, size_t max_width)
+{
+	constexpr int N = 256;
+	vector<string> aux;         // auxiliary vector of strings
+	array<int, N + 1> count;    // count of valid characters: one for each character.
+
+	/*
+	 * Repeat max_width times from least significant digit
+	 * (LSD) to most significant digit (MSD) sorting strings
+	 * based on the character at index w - 1.
+	 */
+	for (size_t w = max_width; w > 0; --w) {
+		// character index we are dealing with.
+		int idx = w - 1;
+
+		// copy all elements to the auxiliary vector.
+		for (auto e : elements)
+			aux.push_back(e);
+
+		// initialize all the counters to 0.
+		for (size_t c = 0; c <= N; ++c)
+			count[c] = 0;
+
+		/*
+		 * Set the count of each character. There is a trick here.
+		 * Instead of setting the count[char_at(a, idx)], it sets
+		 * count[char_at(a, idx) + 1].
+		 */
+		for (auto a : aux)
+			count[char_at(a, idx) + 1]++;
+
+		// Calculated the cumulative count.
+		for (size_t c = 0; c < N; ++c)
+			count[c + 1] += count[c];
+
+		/*
+		 * Now count[char_at(a, idx)] represents the index where the
+		 * string should be copied into the main vector. count[char_at(a, idx)]
+		 * is incremented to represent the next index in case the character
+		 * is seen again.
+		 */
+		for (auto a : aux)
+			elements[count[char_at(a, idx)]++] = a;
+
+		aux.clear();
+
+#if defined(DEBUG)
+		cout << "w = " << w << " : " << elements << endl;
+#endif // DEBUG
+	}
+
+	return;
+}
+
+/*
+ * MSD radix sort. The sort uses key index count sorting.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [in]    aux       - an auxiliary vector.
+ * @param [in]    lo        - process elements starting from lo index.
+ * @param [in]    hi        - process elements upto hi index (non inclusive).
+ * @param [in]    w         - position at which the character is to be processed.
+ * @paran [in]    max_width - the maximum size of string across
+ *                            all elements of the vector.
+ * @return elements are sorted on return.
+ */
+inline void
+msd_radix_sort(vector<string> &elements, vector<string> &aux, size_t lo, size_t hi, size_t w, size_t max_width)
+{
+	constexpr int N = 256;
+	array<int, N + 1> count;    // count of valid characters: one for each character <== trick
+	array<int, N> count2;       // count of valid characters: one for each character <== no trick
+
+	// have we scanned all the elements
+	if (w == max_width)
+		return;
+
+	// check if there is no elements or a single element to process.
+	if ((lo == hi) || ((lo + 1) == hi))
+		return;
+
+	// copy all elements to the auxiliary vector.
+	for (size_t i = lo; i < hi; ++i)
+		aux.push_back(elements[i]);
+
+	// initialize all the counters to 0.
+	for (size_t c = 0; c <= N; ++c)
+		count[c] = 0;
+
+	for (size_t c = 0; c < N; ++c)
+		count2[c] = 0;
+
+	/*
+	 * Set the count of each character. There is a trick here.
+	 * Instead of setting the count[char_at(a, idx)], it sets
+	 * count[char_at(a, idx) + 1].
+	 */
+	for (auto a : aux) {
+		int idx = char_at(a, w);
+		count[idx + 1]++;   // trick
+		count2[idx]++;      // no-trick
+	}
+
+	// set the cumulative count.
+	for (size_t c = 0; c < N; ++c)
+		count[c + 1] += count[c];
+
+	/*
+	 * Now lo + count[char_at(a, idx)] represents the index where the
+	 * string should be copied in the main vector. count[char_at(a, idx)]
+	 * is incremented to represent the next index in case the character
+	 * is seen again.
+	 */
+	for (auto a : aux)
+		elements[lo + count[char_at(a, w)]++] = a;
+
+	aux.clear();
+
+#if defined(DEBUG)
+	cout << "w = " << w + 1 << ", lo = " << lo << ", hi = " << hi << " : ";
+	for (size_t i = 0; i < elements.size(); ++i) {
+		if (i != 0)
+			cout << ", ";
+		if ((i < lo) || (i >= hi))
+			cout << "-";
+		else
+			cout << elements[i];
+	}
+	cout << endl;
+#endif // DEBUG
+
+	/*
+	 * The elements are now sorted based on character at position w.
+	 * Dive deep to sort elements at character position w + 1.
+	 * count2 tells us how many string to process.
+	 */
+	while (lo < hi) {
+		int num_of_elem = count2[char_at(elements[lo], w)];
+		msd_radix_sort(elements, aux, lo, lo + num_of_elem, w + 1, max_width);
+		lo += num_of_elem;
+	}
+
+	return;
+}
+
+/*
+ * MSD radix sort.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @paran [in]    max_width - the maximum size of string across
+ *                            all elements of the vector.
+ *
+ * @return elements are sorted on return.
+ */
+inline void
+msd_radix_sort(vector<string> &elements, size_t max_width)
+{
+	vector<string> aux;     // auxiliary vector of strings
+	msd_radix_sort(elements, aux, 0, elements.size(), 0, max_width);
+}
+
+/*
+ * Perform bubble sort.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T, typename S>
+void
+bubble_sort(vector<T> &elements, S &stats)
+{
+	size_t length = elements.size();
+
+	for (size_t i = 0; i < length - 1; ++i) {
+		for (size_t j = 0; j < length - i - 1; ++j) {
+			stats.compare();
+			if (elements[j] > elements[j + 1]) {
+				stats.swap();
+				swap(elements[j], elements[j + 1]);
+			}
+		}
+
+		stats.step(i + 1, elements);
+	}
+}
+
+template<typename T>
+void
+bubble_sort(vector<T> &elements)
+{
+	sort_stats stats;
+	bubble_sort(elements, stats);
+}
+
+/*
+ * Perform selection sort.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T, typename S>
+void
+selection_sort(vector<T> &elements, S &stats)
+{
+	for (size_t i = 0; i < elements.size() - 1; ++i) {
+		size_t min_idx = i;
+
+		for (size_t j = i + 1; j < elements.size(); ++j) {
+			stats.compare();
+			if (elements[j] < elements[min_idx]) {
+				min_idx = j;
+			}
+		}
+
+		if (min_idx != i) {
+			stats.swap();
+			swap(elements[i], elements[min_idx]);
+		}
+
+		stats.step(i + 1, elements);
+	}
+}
+
+template<typename T>
+void
+selection_sort(vector<T> &elements)
+{
+	sort_stats stats;
+	selection_sort(elements, stats);
+}
+
+/*
+ * Perform insertion sort.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T, typename S>
+void
+insertion_sort(vector<T> &elements, S &stats)
+{
+	/*
+	 * All items to the left of i are sorted and items
+	 * to the right of i, including i, are unsorted.
+	 */
+	for (size_t i = 1; i < elements.size(); ++i) {
+		for (size_t j = i; j > 0; --j) {
+			stats.compare();
+			if (elements[j] < elements[j - 1]) {
+				stats.swap();
+				swap(elements[j], elements[j - 1]);
+			} else {
+				/*
+				 * No point in proceeding further as the elements
+				 * to the left of index i are already sorted.
+				 */
+				break;
+			}
+		}
+
+		stats.step(i, elements);
+	}
+}
+
+template<typename T>
+void
+insertion_sort(vector<T> &elements)
+{
+	sort_stats stats;
+	insertion_sort(elements, stats);
+}
+
+/*
+ * Merge two sorted arrays: elements[lo, mid) and elements[mid, hi).
+ * Items from elements[lo, hi) are first copied into an auxiliary array.
+ * Items from auxiliary[lo, mid) and auxiliary[mid, hi) are then
+ * merged back into the elements[lo, hi).
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [inout] auxiliary - the auxiliary vector to aid sorting.
+ * @param [in]    lo        - the starting index.
+ * @param [in]    mid       - the middle index.
+ * @param [in]    hi        - the ending index (1 past the last item).
+ * @param [in]    iter      - the iteration number.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return elements[lo, hi) are merged correctly on return.
+ */
+template<typename T, typename S>
+static void
+merge(vector<T> &elements, vector<T> &auxiliary, size_t lo, size_t mid, size_t hi, size_t iter, S &stats)
+{
+	if ((lo == mid) || (mid == hi)) {
+		// at least one of the sub-sequence is empty
+		return;
+	}
+
+	for (size_t k = lo; k < hi; ++k) {
+		// copy concerned elements to auxiliary vector
+		auxiliary[k] = elements[k];
+	}
+
+	size_t i = lo;
+	size_t j = mid;
+
+	if (auxiliary[mid - 1] < auxiliary[mid]) {
+		/*
+		 * Special case:
+		 * auxiliary[lo, mid) = ( 2, 3, 4, 5 )
+		 * auxiliary[mid, hi) = ( 7, 9, 10, 11 )
+		 * Nothing to do.
+		 */
+		stats.compare();
+	} else if (auxiliary[lo] > auxiliary[hi - 1]) {
+		/*
+		 * Special case:
+		 * auxiliary[lo, mid) = ( 7, 9, 10, 11 )
+		 * auxiliary[mid, hi) = ( 2, 3, 4, 5 )
+		 * First copy auxiliary[mid, hi), then copy auxiliary[lo, mid).
+		 */
+		stats.compare();
+		for (size_t k = mid; k < hi; ++k) {
+			stats.copy();
+			elements[i++] = auxiliary[k];
+		}
+		for (size_t k = lo; k < mid; ++k) {
+			stats.copy();
+			elements[i++] = auxiliary[k];
+		}
+	} else {
+		/*
+		 * Normal case:
+		 * Do normal comparison and pick element either from
+		 * auxiliary[lo, mid) or auxiliary[mid, hi).
+		 */
+		for (size_t k = lo; k < hi; ++k) {
+			stats.copy();
+			if (i >= mid) {
+				// all elements from auxiliary[lo, mid) are consumed
+				elements[k] = auxiliary[j++];
+			} else if (j >= hi) {
+				// all elements from auxiliary[mid, hi) are consumed
+				elements[k] = auxiliary[i++];
+			} else if (auxiliary[i] < auxiliary[j]) {
+				elements[k] = auxiliary[i++];
+				stats.compare();
+			} else {
+				elements[k] = auxiliary[j++];
+				stats.compare();
+			}
+		}
+	}
+
+	stats.step(iter, lo, hi, elements, true);
+}
+
+/*
+ * Perform merge sort.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [inout] auxiliary - the auxiliary vector to aid sorting.
+ * @param [in]    lo        - the starting index.
+ * @param [in]    ho        - the ending index (1 past the last item).
+ * @param [in]    iter      - the iteration number.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return elements[lo, hi) are storted on return.
+ */
+template<typename T, typename S>
+static void
+merge_sort_v1(vector<T> &elements, vector<T> &auxiliary, size_t lo, size_t hi, size_t &iter, S &stats)
+{
+	if ((hi - lo) <= 1) {
+		// there is only one element left
+		return;
+	}
+
+	// get the partition point
+	size_t mid = (lo + hi) / 2;
+
+	// sort the lhs sequence
+	merge_sort_v1(elements, auxiliary, lo, mid, iter, stats);
+
+	// sort the rhs sequence
+	merge_sort_v1(elements, auxiliary, mid, hi, iter, stats);
+
+	// merge lhs & rhs
+	merge(elements, auxiliary, lo, mid, hi, iter++, stats);
+}
+
+/*
+ * Perform merge sort using recursion.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T, typename S>
+void
+merge_sort_v1(vector<T> &elements, S &stats)
+{
+	// create an auxiliary sequence
+	vector<T> auxiliary(elements.size());
+
+	size_t iter = 1;
+
+	// make the recursive call
+	merge_sort_v1(elements, auxiliary, 0, elements.size(), iter, stats);
+}
+
+template<typename T>
+void
+merge_sort_v1(vector<T> &elements)
+{
+	sort_stats stats;
+	merge_sort_v1(elements, stats);
+}
+
+/*
+ * Perform merge sort without using recursion.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T, typename S>
+void
+merge_sort_v2(vector<T> &elements, S &stats)
+{
+	// create an auxiliary sequence
+	vector<T> auxiliary(elements.size());
+
+	size_t iter = 0;
+	size_t sz = 1;
+
+	/*
+	 * int keys: start from runs of 64 elements sorted with a sorting
+	 * network (see simd.h), when the CPU has one and nothing is counted.
+	 */
+	if (!S::enabled)
+		sz = simd_sort_runs(elements);
+
+	/*
+	 * Keep doubling the merge size, starting with 1.
+	 * Do not use the stop condition as sz < elements.size() / 2.
+	 * This will work only if the number of elements are 2 * power(n).
+	 */
+	for (; sz < elements.size(); sz *= 2) {
+		size_t n = 2 * sz;
+
+		for (size_t lo = 0; lo < elements.size() - sz; lo += n) {
+			size_t mid = lo + sz;
+			size_t hi = lo + n;
+			if (hi > elements.size())
+				hi = elements.size();
+			merge(elements, auxiliary, lo, mid, hi, ++iter, stats);
+		}
+	}
+}
+
+template<typename T>
+void
+merge_sort_v2(vector<T> &elements)
+{
+	sort_stats stats;
+	merge_sort_v2(elements, stats);
+}
+
+/*
+ * Wins in a row after which a merge starts galloping.
+ */
+constexpr size_t min_gallop = 7;
+
+/*
+ * Number of leading elements of base[0, n) for which pred() holds; pred()
+ * holds on a prefix. Probes 1, 3, 7, ... elements in, then searches
+ * between the last two probes, so a short answer costs few comparisons
+ * and a long one O(log n).
+ */
+template<typename T, typename P>
+size_t
+gallop(const T *base, size_t n, P pred)
+{
+	size_t lo = 0;
+	size_t hi = 1;
+
+	while ((hi <= n) && pred(base[hi - 1])) {
+		lo = hi;
+		hi = 2 * hi + 1;
+	}
+	hi = min(hi - 1, n);
+
+	while (lo < hi) {
+		size_t m = lo + (hi - lo) / 2;
+		if (pred(base[m]))
+			lo = m + 1;
+		else
+			hi = m;
+	}
+	return lo;
+}
+
+/*
+ * Number of trailing elements of base[0, n) for which pred() holds; pred()
+ * holds on a suffix.
+ */
+template<typename T, typename P>
+size_t
+gallop_back(const T *base, size_t n, P pred)
+{
+	size_t lo = 0;
+	size_t hi = 1;
+
+	while ((hi <= n) && pred(base[n - hi])) {
+		lo = hi;
+		hi = 2 * hi + 1;
+	}
+	hi = min(hi - 1, n);
+
+	while (lo < hi) {
+		size_t m = lo + (hi - lo) / 2;
+		if (pred(base[n - 1 - m]))
+			lo = m + 1;
+		else
+			hi = m;
+	}
+	return lo;
+}
+
+/*
+ * Merge the sorted runs a[0, n1) and a[n1, n1 + n2), n1 <= n2, with the
+ * first run moved to tmp: the output is written from the front and never
+ * overtakes the second run. When one run wins min_gallop times in a row,
+ * the merge gallops: it finds how many elements of each run go next with
+ * gallop() and moves them in one go, until the blocks get short again.
+ * Equal elements are taken from the first run first (stable).
+ */
+template<typename T>
+void
+power_merge_lo(T *a, size_t n1, size_t n2, vector<T> &tmp)
+{
+	T *left = tmp.data();
+	T *right = a + n1;
+	T *right_end = right + n2;
+	T *dest = a;
+	size_t i = 0;
+
+	move(a, a + n1, left);
+
+	while ((i < n1) && (right < right_end)) {
+		size_t wins1 = 0;
+		size_t wins2 = 0;
+
+		while ((i < n1) && (right < right_end) && (wins1 < min_gallop) && (wins2 < min_gallop)) {
+			if (*right < left[i]) {
+				*dest++ = std::move(*right++);
+				wins2++;
+				wins1 = 0;
+			} else {
+				*dest++ = std::move(left[i++]);
+				wins1++;
+				wins2 = 0;
+			}
+		}
+
+		for (;;) {
+			if ((i == n1) || (right == right_end))
+				break;
+
+			const T &r = *right;
+			size_t k1 = gallop(left + i, n1 - i, [&](const T &x) { return !(r < x); });
+			dest = move(left + i, left + i + k1, dest);
+			i += k1;
+			if (i == n1)
+				break;
+
+			const T &l = left[i];
+			size_t k2 = gallop(right, right_end - right, [&](const T &x) { return x < l; });
+			dest = move(right, right + k2, dest);
+			right += k2;
+			if (right == right_end)
+				break;
+
+			if ((k1 < min_gallop) && (k2 < min_gallop))
+				break;
+		}
+	}
+
+	move(left + i, left + n1, dest);
+}
+
+/*
+ * Merge the sorted runs a[0, n1) and a[n1, n1 + n2), n1 > n2, with the
+ * second run moved to tmp: the output is written from the back.
+ */
+template<typename T>
+void
+power_merge_hi(T *a, size_t n1, size_t n2, vector<T> &tmp)
+{
+	T *right = tmp.data();
+	T *dest = a + n1 + n2;
+	size_t i = n1;
+	size_t j = n2;
+
+	move(a + n1, a + n1 + n2, right);
+
+	while ((i > 0) && (j > 0)) {
+		size_t wins1 = 0;
+		size_t wins2 = 0;
+
+		while ((i > 0) && (j > 0) && (wins1 < min_gallop) && (wins2 < min_gallop)) {
+			if (right[j - 1] < a[i - 1]) {
+				*--dest = std::move(a[--i]);
+				wins1++;
+				wins2 = 0;
+			} else {
+				*--dest = std::move(right[--j]);
+				wins2++;
+				wins1 = 0;
+			}
+		}
+
+		for (;;) {
+			if ((i == 0) || (j == 0))
+				break;
+
+			const T &r = right[j - 1];
+			size_t k1 = gallop_back(a, i, [&](const T &x) { return r < x; });
+			dest = move_backward(a + i - k1, a + i, dest);
+			i -= k1;
+			if (i == 0)
+				break;
+
+			const T &l = a[i - 1];
+			size_t k2 = gallop_back(right, j, [&](const T &x) { return !(x < l); });
+			dest = move_backward(right + j - k2, right + j, dest);
+			j -= k2;
+			if (j == 0)
+				break;
+
+			if ((k1 < min_gallop) && (k2 < min_gallop))
+				break;
+		}
+	}
+
+	move_backward(right, right + j, dest);
+}
+
+/*
+ * Merge the neighbouring sorted runs a[0, n1) and a[n1, n1 + n2). The
+ * elements of the first run not greater than the first element of the
+ * second, and those of the second not less than the last of the first,
+ * are already in place; only the rest is merged, through a buffer the size
+ * of the shorter of what is left of the two runs.
+ */
+template<typename T>
+void
+power_merge(T *a, size_t n1, size_t n2, vector<T> &tmp)
+{
+	const T &first2 = a[n1];
+	size_t skip = gallop(a, n1, [&](const T &x) { return !(first2 < x); });
+
+	a += skip;
+	n1 -= skip;
+	if (n1 == 0)
+		return;
+
+	const T &last1 = a[n1 - 1];
+	n2 -= gallop_back(a + n1, n2, [&](const T &x) { return !(x < last1); });
+	if (n2 == 0)
+		return;
+
+	if (tmp.size() < min(n1, n2))
+		tmp.resize(min(n1, n2));
+
+	if (n1 <= n2)
+		power_merge_lo(a, n1, n2, tmp);
+	else
+		power_merge_hi(a, n1, n2, tmp);
+}
+
+/*
+ * Find the run that starts at a[0] (of at most n elements): the longest
+ * non-decreasing or strictly decreasing prefix, the latter reversed in
+ * place (being strict, reversing it keeps the sort stable). A run shorter
+ * than min_run is extended to min_run elements with insertion sort.
+ *
+ * @return the length of the run.
+ */
+template<typename T>
+size_t
+power_run(T *a, size_t n, size_t min_run)
+{
+	size_t len = 1;
+
+	if (n <= 1)
+		return n;
+
+	if (a[1] < a[0]) {
+		len = 2;
+		while ((len < n) && (a[len] < a[len - 1]))
+			len++;
+		reverse(a, a + len);
+	} else {
+		len = 2;
+		while ((len < n) && !(a[len] < a[len - 1]))
+			len++;
+	}
+
+	if (len < min_run) {
+		size_t end = min(min_run, n);
+		for (; len < end; ++len) {
+			T x = std::move(a[len]);
+			size_t j = len;
+			for (; (j > 0) && (x < a[j - 1]); --j)
+				a[j] = std::move(a[j - 1]);
+			a[j] = std::move(x);
+		}
+	}
+
+	return len;
+}
+
+/*
+ * Powersort merge policy (Munro and Wild): the power of the boundary
+ * between the runs [s1, s1 + n1) and [s1 + n1, s1 + n1 + n2) of an
+ * array of n elements is the depth, in a perfectly balanced merge tree
+ * over [0, n), of the node that splits the midpoints of the two runs.
+ */
+inline unsigned
+power_of(size_t s1, size_t n1, size_t n2, size_t n)
+{
+	uint64_t a = 2 * uint64_t(s1) + n1;
+	uint64_t b = a + n1 + n2;
+	unsigned power = 0;
+
+	for (;;) {
+		power++;
+		if (a >= n) {
+			a -= n;
+			b -= n;
+		} else if (b >= n) {
+			break;
+		}
+		a <<= 1;
+		b <<= 1;
+	}
+	return power;
+}
+
+/*
+ * Powersort: an adaptive, stable natural merge sort.
+ *
+ * The input is cut into the runs it already has (descending ones are
+ * reversed, short ones extended to min_run with insertion sort) and the
+ * runs are kept on a stack. The boundary between each run and the next
+ * one gets a power (power_of()); before a run is pushed, the runs on the
+ * stack whose boundary has a higher power are merged into it, so that the merges follow
+ * a nearly optimal merge tree for the run lengths. Sorted or reverse
+ * sorted input is one run and takes n - 1 comparisons; k runs take
+ * O(n log k). The merges gallop over long blocks (power_merge()) and need
+ * a buffer of at most n / 2 elements.
+ *
+ * @param [inout] elements  - the vector to sort.
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T>
+void
+power_sort(vector<T> &elements)
+{
+	struct run
+	{
+		size_t start;
+		size_t len;
+		unsigned power;     // power of the boundary after the run
+	};
+
+	size_t n = elements.size();
+	T *a = elements.data();
+	vector<run> stack;
+	vector<T> tmp;
+
+	if (n < 2)
+		return;
+
+	/*
+	 * min_run in [16, 32], such that n / min_run is just below a power
+	 * of 2, as TimSort does, so the runs merge evenly.
+	 */
+	size_t min_run = n;
+	size_t rest = 0;
+	while (min_run >= 32) {
+		rest |= min_run & 1;
+		min_run >>= 1;
+	}
+	min_run += rest;
+
+	size_t start = 0;
+	size_t len = power_run(a, n, min_run);
+
+	while (start + len < n) {
+		size_t next = start + len;
+		size_t next_len = power_run(a + next, n - next, min_run);
+		unsigned power = power_of(start, len, next_len, n);
+
+		while (!stack.empty() && (stack.back().power > power)) {
+			run r = stack.back();
+			stack.pop_back();
+			power_merge(a + r.start, r.len, next - r.start - r.len, tmp);
+			len += r.len;
+			start = r.start;
+		}
+
+		stack.push_back({ start, len, power });
+		start = next;
+		len = next_len;
+	}
+
+	while (!stack.empty()) {
+		run r = stack.back();
+		stack.pop_back();
+		power_merge(a + r.start, r.len, start + len - r.start - r.len, tmp);
+		len += start - r.start;
+		start = r.start;
+	}
+}
+
+/*
+ * Partitions the vector into two. The first element elements[lo] is the pivot element.
+ * After partition, array[lo] is moved to its correct position. All the elements to
+ * left of the pivot are less than array[lo] and all the elements to the right of
+ * the pivot are greater than array[lo]. Returns the index of the pivot element position.
+ *
+ * @param [inout] elements  - the input vector to partition.
+ * @param [in]    lo        - the starting index.
+ * @param [in]    hi        - the ending index.
+ * @param [in]    iter      - the current iteration.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return the index of the pivot element after the vector is partitioned.
+ */
+template<typename T, typename S>
+size_t
+partition(vector<T> &elements, size_t lo, size_t hi, size_t iter, S &stats)
+{
+	size_t i = lo + 1;
+	size_t j = hi;
+
+	while (i <= j) {
+		stats.compare();
+		if (elements[i] < elements[lo]) {
+			i++;
+		} else if (elements[j] > elements[lo]) {
+			j--;
+		} else {
+			swap(elements[i], elements[j]);
+			i++;
+			j--;
+			stats.swap();
+		}
+	}
+
+	if (lo != j) {
+		swap(elements[lo], elements[j]);
+		stats.swap();
+	}
+
+	stats.step(iter, lo, hi, elements);
+
+	return j;
+}
+
+/*
+ * Partitions the vector into three. The first element elements[lo] is the pivot element.
+ * There may be multiple occurrence of the pivot element. After partition, the vector
+ * is divided into 3 segments: 1st segment with elements less than pivot element,
+ * 2nd segement with all pivot elements(s), and 3rd segment with all elements greater
+ * than pivot element.
+ *
+ * @param [inout] elements  - the input vector to partition.
+ * @param [in]    lo        - the starting index.
+ * @param [in]    hi        - the ending index.
+ * @param [out]   p1        - the stating index of the pivot element.
+ * @param [out]   p2        - the ending index of the pivot element.
+ * @param [in]    iter      - the current iteration.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ */
+template<typename T, typename S>
+void
+partition(vector<T> &elements, size_t lo, size_t hi, size_t &p1, size_t &p2, size_t iter, S &stats)
+{
+	size_t i = lo + 1;
+
+	p1 = lo;
+	p2 = hi;
+
+	while (i <= p2) {
+		stats.compare();
+		if (elements[i] < elements[p1]) {
+			swap(elements[i], elements[p1]);
+			i++;
+			p1++;
+			stats.swap();
+		} else if (elements[i] == elements[p1]) {
+			i++;
+		} else /* if (elements[i] > elements[p1]) */ {
+			swap(elements[i], elements[p2]);
+			// Do not increment i, the new element at i could still be greater than pivot
+			p2--;
+			stats.swap();
+		}
+	}
+
+	stats.step(iter, lo, hi, elements);
+}
+
+/**
+ * Quick Sort. Consider shuffling the items if the sequence is not randomly
+ * distributed. Find a pivot element and move it to its correct location
+ * using partition(). Recursively sort the first half and the second half.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [in]    lo        - the starting index.
+ * @param [in]    hi        - the ending index.
+ * @param [in]    iter      - the current iteration.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T, typename S>
+void
+quick_sort_v1(vector<T> &elements, size_t lo, size_t hi, size_t &iter, S &stats)
+{
+	if (lo >= hi)
+		return;
+
+	size_t p = partition(elements, lo, hi, ++iter, stats);
+
+	if (p > lo)
+		quick_sort_v1(elements, lo, p - 1, iter, stats);
+
+	if (p < hi)
+		quick_sort_v1(elements, p + 1, hi, iter, stats);
+}
+
+/*
+ * Perform quick sort.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T, typename S>
+void
+quick_sort_v1(vector<T> &elements, S &stats)
+{
+	if (elements.empty())
+		return;
+
+	size_t iter = 0;
+
+	quick_sort_v1(elements, 0, elements.size() - 1, iter, stats);
+}
+
+template<typename T>
+void
+quick_sort_v1(vector<T> &elements)
+{
+	sort_stats stats;
+	quick_sort_v1(elements, stats);
+}
+
+/**
+ * 3-way quick sort.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [in]    lo        - the starting index.
+ * @param [in]    hi        - the ending index.
+ * @param [in]    iter      - the current iteration.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T, typename S>
+void
+quick_sort_v2(vector<T> &elements, size_t lo, size_t hi, size_t &iter, S &stats)
+{
+	size_t p1, p2;
+
+	if (lo >= hi)
+		return;
+
+	/*
+	 * int keys: sorting network for up to 64 elements and a vectorized
+	 * partition (see simd.h), when the CPU has them and nothing is
+	 * counted. Other keys (strings) are split by a k-way partition with
+	 * k = 3 (see kway.h): one 3-way comparison per element instead of up
+	 * to two, and no branch on its result. Numbers compare in one
+	 * instruction, and partition() is as fast for them.
+	 */
+	if (S::enabled) {
+		partition(elements, lo, hi, p1, p2, ++iter, stats);
+	} else {
+		if (simd_sort_small(elements, lo, hi))
+			return;
+
+		if (!simd_partition3(elements, lo, hi, p1, p2)) {
+			if constexpr (is_arithmetic<T>::value)
+				partition(elements, lo, hi, p1, p2, ++iter, stats);
+			else
+				kway_partition3(elements, lo, hi, p1, p2);
+		}
+	}
+
+	if (p1 > lo)
+		quick_sort_v2(elements, lo, p1 - 1, iter, stats);
+
+	if (p2 < hi)
+		quick_sort_v2(elements, p2 + 1, hi, iter, stats);
+}
+
+/*
+ * Perform quick sort.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T, typename S>
+void
+quick_sort_v2(vector<T> &elements, S &stats)
+{
+	if (elements.empty())
+		return;
+
+	size_t iter = 0;
+
+	quick_sort_v2(elements, 0, elements.size() - 1, iter, stats);
+}
+
+template<typename T>
+void
+quick_sort_v2(vector<T> &elements)
+{
+	sort_stats stats;
+	quick_sort_v2(elements, stats);
+}
+
+/*
+ * Percolates an element down to its correct location in the heap.
+ * We are dealing with maximum heap.
+ *
+ * @param [inout] elements - the vector to fix.
+ * @param [in]    n        - the size of the vector. Do not rely on elements.size().
+ * @param [in]    i        - the element index that needs to be moved, if needed.
+ * @param [in]    iter     - the current iteration.
+ * @param [inout] stats    - the instrumentation policy (see stats.h).
+ * @param [in]    incrswap - the flag to increment swap count by 1.
+ */ 
+template<typename T, typename S>
+static void
+heap_sink(vector<T> &elements, int n, int i, size_t iter, S &stats, bool incrswap = false)
+{
+	if (n <= 1)
+		return;
+
+	if (incrswap)
+		stats.swap();
+
+	while (i < n) {
+		int l = 2 * i + 1;
+		int r = 2 * i + 2;
+		int c;
+
+		if (l >= n) {
+			c = r;
+		} else if (r >= n) {
+			c = l;
+		} else if (elements[l] > elements[r]) {
+			c = l;
+			stats.compare();
+		} else {
+			c = r;
+			stats.compare();
+		}
+
+		if ((c < n) && (elements[c] > elements[i])) {
+			swap(elements[c], elements[i]);
+			i = c;
+			stats.compare();
+			stats.swap();
+		} else {
+			break;
+		}
+	}
+
+	stats.step(iter, elements);
+}
+
+/*
+ * Perform heap sort.
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [inout] stats     - the instrumentation policy (see stats.h).
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T, typename S>
+static void
+heap_sort(vector<T> &elements, S &stats)
+{
+	if (elements.empty())
+		return;
+
+	size_t iter = 0;
+
+	stats.phase("build heap");
+
+	/*
+	 * Change the vector into a maximum heap.
+	 */
+	int n = static_cast<int>(elements.size());
+	for (int i = n / 2 - 1; i >= 0; --i)
+		heap_sink(elements, n, i, ++iter, stats, false);
+
+	stats.phase("heap ready");
+
+	for (int i = n - 1; i > 0; --i) {
+		/* Swap the fist (largest) element with the last element */
+		swap(elements[0], elements[i]);
+
+		/*
+		 * Fix the heap again assuming the heap size is 1 less.
+		 * Notice i is passed as the heap size and not n.
+		 */
+		heap_sink(elements, i, 0, ++iter, stats, true);
+	}
+}
+
+template<typename T>
+static void
+heap_sort(vector<T> &elements)
+{
+	sort_stats stats;
+	heap_sort(elements, stats);
+}
+
+/*
+ * Index of the largest of heap[c, c + D), found by a tournament: the
+ * comparisons of a round do not depend on each other, and for int keys
+ * they compile to conditional moves, which random keys do not
+ * mispredict.
+ */
+template<size_t D, typename T>
+inline size_t
+dary_largest(const T *heap, size_t c)
+{
+	if constexpr (D == 1) {
+		return c;
+	} else {
+		size_t a = dary_largest<D / 2>(heap, c);
+		size_t b = dary_largest<D / 2>(heap, c + D / 2);
+		size_t less = heap[a] < heap[b];
+		return a + less * (b - a);
+	}
+}
+
+/*
+ * Floyd's bottom-up sink in the D-ary maximum heap heap[0, n): the hole
+ * left by heap[i] goes down to a leaf, always to the largest child, and
+ * heap[i] then climbs back up from there. That is D - 1 comparisons per
+ * level on the way down and, since a sunk element nearly always belongs
+ * near the bottom, only one or two on the way up; the top-down sink needs
+ * D per level.
+ */
+template<size_t D, typename T>
+void
+dary_heap_sink(T *heap, size_t n, size_t i)
+{
+	T tmp = std::move(heap[i]);
+	size_t hole = i;
+
+	for (;;) {
+		size_t c = D * hole + 1;
+		size_t m = c;
+
+		if (c + D <= n) {
+			m = dary_largest<D>(heap, c);
+		} else if (c < n) {
+			for (size_t j = c + 1; j < n; ++j) {
+				if (heap[m] < heap[j])
+					m = j;
+			}
+		} else {
+			break;
+		}
+
+		heap[hole] = std::move(heap[m]);
+		hole = m;
+	}
+
+	while (hole > i) {
+		size_t p = (hole - 1) / D;
+		if (!(heap[p] < tmp))
+			break;
+		heap[hole] = std::move(heap[p]);
+		hole = p;
+	}
+
+	heap[hole] = std::move(tmp);
+}
+
+/*
+ * Heap sort on a D-ary heap (D = 2, 4 or 8), with Floyd's bottom-up sink.
+ *
+ * The heap is log2(D) times shallower than a binary one, and the D
+ * children of a node are next to each other: when D elements fill a
+ * fraction of a cache line, the heap starts at the element that makes
+ * every group of children start on a group boundary, so finding the
+ * largest child touches one cache line. The (at most D - 1) elements
+ * before the heap are merged in once the heap is sorted.
+ *
+ * @param [inout] elements  - the vector to sort.
+ *
+ * @return elements are sorted on return.
+ */
+template<size_t D, typename T>
+void
+dary_heap_sort(vector<T> &elements)
+{
+	static_assert((D == 2) || (D == 4) || (D == 8), "D must be 2, 4 or 8");
+
+	size_t s = 0;
+
+	if ((64 % (D * sizeof(T)) == 0) && (elements.size() > 2 * D)) {
+		/*
+		 * Children of heap node i are at s + D * i + 1, so the
+		 * groups are aligned if address / sizeof(T) + s + 1 is a
+		 * multiple of D.
+		 */
+		uintptr_t a = reinterpret_cast<uintptr_t>(elements.data()) / sizeof(T);
+		s = (D - (a + 1) % D) % D;
+	}
+
+	T *heap = elements.data() + s;
+	size_t n = elements.size() - s;
+
+	if (n > 1) {
+		for (size_t i = (n - 2) / D + 1; i > 0; --i)
+			dary_heap_sink<D>(heap, n, i - 1);
+
+		for (size_t i = n - 1; i > 0; --i) {
+			swap(heap[0], heap[i]);
+			dary_heap_sink<D>(heap, i, 0);
+		}
+	}
+
+	if (s > 0) {
+		/*
+		 * Merge the leading elements, sorted and held aside, with the
+		 * sorted heap; the output never catches up with the heap.
+		 */
+		vector<T> lead(make_move_iterator(elements.begin()), make_move_iterator(elements.begin() + s));
+		size_t i = 0;
+		size_t j = s;
+		size_t k = 0;
+
+		sort(lead.begin(), lead.end());
+		while ((i < s) && (j < elements.size())) {
+			if (elements[j] < lead[i])
+				elements[k++] = std::move(elements[j++]);
+			else
+				elements[k++] = std::move(lead[i++]);
+		}
+		while (i < s)
+			elements[k++] = std::move(lead[i++]);
+	}
+}
+
+/*
+ * D-ary heap sort with D chosen at run time (2, 4 or 8).
+ */
+template<typename T>
+void
+dary_heap_sort(vector<T> &elements, unsigned d)
+{
+	switch (d) {
+		case 2:
+			dary_heap_sort<2>(elements);
+			break;
+		case 8:
+			dary_heap_sort<8>(elements);
+			break;
+		case 4:
+		default:
+			dary_heap_sort<4>(elements);
+			break;
+	}
+}
+
+/*
+ * Sort elements[lo, hi] with insertion sort. Used for the small
+ * partitions of intro sort, where it beats further partitioning.
+ */
+template<typename T>
+static void
+insertion_sort(vector<T> &elements, size_t lo, size_t hi)
+{
+	for (size_t i = lo + 1; i <= hi; ++i) {
+		T tmp = std::move(elements[i]);
+		size_t j = i;
+		for (; (j > lo) && (tmp < elements[j - 1]); --j)
+			elements[j] = std::move(elements[j - 1]);
+		elements[j] = std::move(tmp);
+	}
+}
+
+/*
+ * Percolate elements[lo + i] down in the maximum heap elements[lo, lo + n).
+ */
+template<typename T>
+static void
+heap_sink_range(vector<T> &elements, size_t lo, size_t n, size_t i)
+{
+	while (2 * i + 1 < n) {
+		size_t c = 2 * i + 1;
+		if ((c + 1 < n) && (elements[lo + c] < elements[lo + c + 1]))
+			c++;
+		if (!(elements[lo + i] < elements[lo + c]))
+			break;
+		swap(elements[lo + i], elements[lo + c]);
+		i = c;
+	}
+}
+
+/*
+ * Sort elements[lo, hi] with heap sort. Intro sort falls back on it when
+ * the partitions keep coming out lopsided.
+ */
+template<typename T>
+static void
+heap_sort_range(vector<T> &elements, size_t lo, size_t hi)
+{
+	size_t n = hi - lo + 1;
+
+	for (size_t i = n / 2; i > 0; --i)
+		heap_sink_range(elements, lo, n, i - 1);
+
+	for (size_t i = n - 1; i > 0; --i) {
+		swap(elements[lo], elements[lo + i]);
+		heap_sink_range(elements, lo, i, 0);
+	}
+}
+
+/*
+ * Index of the median of elements[a], elements[b] and elements[c].
+ */
+template<typename T>
+static size_t
+median_of_3(const vector<T> &elements, size_t a, size_t b, size_t c)
+{
+	if (elements[a] < elements[b]) {
+		if (elements[b] < elements[c])
+			return b;
+		return (elements[a] < elements[c]) ? c : a;
+	}
+
+	if (elements[a] < elements[c])
+		return a;
+	return (elements[b] < elements[c]) ? c : b;
+}
+
+/*
+ * Pick the pivot of elements[lo, hi]: the median of the first, middle and
+ * last elements, or for large partitions the median of three such medians
+ * (Tukey's ninther). Sorted, reverse sorted and organ pipe inputs then
+ * split evenly.
+ */
+template<typename T>
+static size_t
+choose_pivot(const vector<T> &elements, size_t lo, size_t hi)
+{
+	size_t mid = lo + (hi - lo) / 2;
+
+	if (hi - lo < 128)
+		return median_of_3(elements, lo, mid, hi);
+
+	size_t step = (hi - lo) / 8;
+	return median_of_3(elements,
+		median_of_3(elements, lo, lo + step, lo + 2 * step),
+		median_of_3(elements, mid - step, mid, mid + step),
+		median_of_3(elements, hi - 2 * step, hi - step, hi));
+}
+
+/*
+ * Intro sort.
+ *
+ * Quick sort with:
+ * - a median of 3 (ninther for large partitions) pivot, moved to
+ *   elements[lo] for block_partition() (see partition.h). Elements equal
+ *   to the pivot go to both sides, so duplicates split evenly too.
+ * - a recursion depth limit of 2 * log2(n). A partition that goes deeper
+ *   is sorted with heap sort, so the worst case is O(n * log(n)).
+ * - insertion sort for partitions of 16 elements or less.
+ * - a recursive call for the smaller side only; the larger side is
+ *   sorted by the loop, so the stack depth is at most log2(n).
+ *
+ * @param [inout] elements  - the vector to sort.
+ * @param [in]    lo        - the starting index.
+ * @param [in]    hi        - the ending index.
+ * @param [in]    depth     - the number of partitioning levels left.
+ *
+ * @return elements[lo, hi] are sorted on return.
+ */
+template<typename T>
+static void
+intro_sort(vector<T> &elements, size_t lo, size_t hi, size_t depth)
+{
+	constexpr size_t insertion_cutoff = 16;
+
+	while (hi - lo >= insertion_cutoff) {
+		if (depth == 0) {
+			heap_sort_range(elements, lo, hi);
+			return;
+		}
+		depth--;
+
+		swap(elements[lo], elements[choose_pivot(elements, lo, hi)]);
+		size_t p = block_partition(elements, lo, hi);
+
+		if (p - lo < hi - p) {
+			if (p > lo)
+				intro_sort(elements, lo, p - 1, depth);
+			lo = p + 1;
+		} else {
+			intro_sort(elements, p + 1, hi, depth);
+			hi = p - 1;
+		}
+	}
+
+	insertion_sort(elements, lo, hi);
+}
+
+/*
+ * Perform intro sort.
+ *
+ * @param [inout] elements  - the vector to sort.
+ *
+ * @return elements are sorted on return.
+ */
+template<typename T>
+void
+intro_sort(vector<T> &elements)
+{
+	if (elements.size() <= 1)
+		return;
+
+	size_t depth = 0;
+
+	for (size_t n = elements.size(); n > 1; n /= 2)
+		depth += 2;
+
+	intro_sort(elements, 0, elements.size() - 1, depth);
+}
+
+template<typename T>
+static void
+mom_select(vector<T> &elements, size_t lo, size_t hi, size_t k);
+
+/*
+ * Index of the median of medians of elements[lo, hi]: the medians of the
+ * groups of 5 are moved to the front and their median is selected
+ * recursively. At least 3/10 of the elements are on either side of it.
+ */
+template<typename T>
+static size_t
+median_of_medians(vector<T> &elements, size_t lo, size_t hi)
+{
+	size_t m = 0;
+
+	for (size_t i = lo; i + 4 <= hi; i += 5) {
+		insertion_sort(elements, i, i + 4);
+		swap(elements[lo + m], elements[i + 2]);
+		m++;
+	}
+
+	mom_select(elements, lo, lo + m - 1, lo + m / 2);
+
+	return lo + m / 2;
+}
+
+/*
+ * Move the kth smallest element of elements[lo, hi] to elements[k], with
+ * median of medians pivots. Linear in the worst case, but with a large
+ * constant, so it is only the fallback of floyd_rivest_select().
+ */
+template<typename T>
+static void
+mom_select(vector<T> &elements, size_t lo, size_t hi, size_t k)
+{
+	while (hi - lo >= 16) {
+		swap(elements[lo], elements[median_of_medians(elements, lo, hi)]);
+		size_t p = block_partition(elements, lo, hi);
+
+		if (p == k)
+			return;
+		else if (p < k)
+			lo = p + 1;
+		else
+			hi = p - 1;
+	}
+
+	insertion_sort(elements, lo, hi);
+}
+
+/*
+ * Move the kth smallest element of elements[lo, hi] to elements[k], with
+ * the smaller elements before and the larger ones after it.
+ *
+ * Floyd-Rivest: for a large range, the pivot is the element of the same
+ * rank in a sample of about n^(2/3) elements around k, selected
+ * recursively. It is then very close to the kth element, so that nearly
+ * all of the range is discarded by one partition, and about
+ * n + min(k, n - k) comparisons are needed. Smaller ranges use the
+ * pivots of intro sort. If depth partitions are not enough (a hostile
+ * input), the rest is done by mom_select(), so the worst case is linear.
+ *
+ * @param [inout] elements  - the input sequence.
+ * @param [in]    lo        - the starting index.
+ * @param [in]    hi        - the ending index.
+ * @param [in]    k         - the index to select, in [lo, hi].
+ * @param [in]    depth     - the number of partitions left.
+ */
+template<typename T>
+static void
+floyd_rivest_select(vector<T> &elements, size_t lo, size_t hi, size_t k, size_t depth)
+{
+	while (hi - lo >= 16) {
+		if (depth == 0) {
+			mom_select(elements, lo, hi, k);
+			return;
+		}
+		depth--;
+
+		if (hi - lo > 600) {
+			double n = hi - lo + 1;
+			double i = k - lo + 1;
+			double z = log(n);
+			double s = 0.5 * exp(2 * z / 3);
+			double sd = 0.5 * sqrt(z * s * (n - s) / n) * ((i < n / 2) ? -1 : 1);
+			double l = k - i * s / n + sd;
+			double h = k + (n - i) * s / n + sd;
+			size_t sl = min(max(lo, static_cast<size_t>(max(l, 0.0))), k);
+			size_t sh = max(min(hi, static_cast<size_t>(h)), k);
+
+			floyd_rivest_select(elements, sl, sh, k, depth);
+			swap(elements[lo], elements[k]);
+		} else {
+			swap(elements[lo], elements[choose_pivot(elements, lo, hi)]);
+		}
+
+		size_t p = block_partition(elements, lo, hi);
+
+		if (p == k)
+			return;
+		else if (p < k)
+			lo = p + 1;
+		else
+			hi = p - 1;
+	}
+
+	insertion_sort(elements, lo, hi);
+}
+
+/*
+ * Number of partitions floyd_rivest_select() may take on n elements.
+ */
+inline size_t
+select_depth(size_t n)
+{
+	size_t depth = 4;
+
+	for (; n > 1; n /= 2)
+		depth += 2;
+	return depth;
+}
+
+/*
+ * Select kth smallest element.
+ *
+ * @param [inout] elements - the input sequence.
+ * @param [in]    k        - the kth smallest element to find.
+ *
+ * @return the kth smallest element.
+ */
+template<typename T>
+T
+select_kth(vector<T> &elements, size_t k)
+{
+	floyd_rivest_select(elements, 0, elements.size() - 1, k, select_depth(elements.size()));
+
+	return elements[k];
+}
+
+/*
+ * Select the elements of the sorted, distinct indices [kb, ke) in
+ * elements[lo, hi]: the middle one is selected first, which partitions
+ * the range for the indices on either side of it.
+ */
+template<typename T>
+static void
+multi_select(vector<T> &elements, size_t lo, size_t hi, const size_t *kb, const size_t *ke, size_t depth)
+{
+	while (kb != ke) {
+		const size_t *mid = kb + (ke - kb) / 2;
+
+		floyd_rivest_select(elements, lo, hi, *mid, depth);
+
+		if (mid != kb)
+			multi_select(elements, lo, *mid - 1, kb, mid, depth);
+
+		lo = *mid + 1;
+		kb = mid + 1;
+	}
+}
+
+/*
+ * Select several order statistics at once, e.g. percentiles. Each level
+ * of the recursion partitions the elements once for half of the indices
+ * left, so m indices take O(n * log(m)) rather than O(n * m).
+ *
+ * @param [inout] elements - the input sequence.
+ * @param [in]    ks       - the indices to find, in any order.
+ *
+ * @return the kth smallest element for every k in ks, in the same order.
+ */
+template<typename T>
+vector<T>
+select_kth(vector<T> &elements, const vector<size_t> &ks)
+{
+	vector<size_t> sorted(ks);
+	vector<T> result;
+
+	sort(sorted.begin(), sorted.end());
+	sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+
+	multi_select(elements, 0, elements.size() - 1,
+		sorted.data(), sorted.data() + sorted.size(), select_depth(elements.size()));
+
+	result.reserve(ks.size());
+	for (size_t k : ks)
+		result.push_back(elements[k]);
+
+	return result;
+}
+
+#endif // SORT_H_
@@ -0,0 +1,481 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <cstdlib>
+#include <climits>
+#include <algorithm>
+#include "sort.h"
+#include "argsort.h"
+#include "prng.h"
+
+using namespace std;
+
+enum distribution
+{
+	SORTED,
+	REVERSE,
+	FEW_UNIQUE,
+	ORGAN_PIPE,
+	BURSTS,
+	ZIPF,
+	RANDOM,
+	NDISTRIBUTIONS
+};
+
+static const char *distribution_names[NDISTRIBUTIONS] = {
+	"sorted", "reverse", "few_unique", "organ_pipe", "bursts", "zipf", "random"
+};
+
+/*
+ * Number of distinct keys of the few_unique inputs.
+ */
+constexpr int few_unique_keys = 16;
+
+/*
+ * The bursts inputs are sorted but for n / burst_every windows of
+ * burst_size elements, each shuffled.
+ */
+constexpr size_t burst_every = 1000;
+constexpr size_t burst_size = 64;
+
+/*
+ * Zipf distributed integers in [1, n]: P(k) is proportional to 1 / k^s.
+ * Rejection-inversion sampling (Hormann and Derflinger), which needs no
+ * table, so n may be as large as the input.
+ */
+class zipf_distribution
+{
+private:
+	double _s;
+	double _n;
+	double _hx1;
+	double _hn;
+	double _c;
+
+	/*
+	 * log1p(x) / x and expm1(x) / x, without the division by zero.
+	 */
+	static double log1p_x(double x)
+	{
+		return (fabs(x) > 1e-8) ? log1p(x) / x : 1 - x / 2;
+	}
+
+	static double expm1_x(double x)
+	{
+		return (fabs(x) > 1e-8) ? expm1(x) / x : 1 + x / 2;
+	}
+
+	/*
+	 * H is an integral of h(x) = 1 / x^s, Hinv its inverse.
+	 */
+	double h(double x) const
+	{
+		return exp(-_s * log(x));
+	}
+
+	double H(double x) const
+	{
+		double lx = log(x);
+		return expm1_x((1 - _s) * lx) * lx;
+	}
+
+	double Hinv(double x) const
+	{
+		double t = max(x * (1 - _s), -1.0);
+		return exp(log1p_x(t) * x);
+	}
+
+public:
+	zipf_distribution(uint64_t n, double s) : _s(s), _n(static_cast<double>(n))
+	{
+		_hx1 = H(1.5) - 1;
+		_hn = H(_n + 0.5);
+		_c = 2 - Hinv(H(2.5) - h(2));
+	}
+
+	template<typename G>
+	uint64_t operator()(G &gen)
+	{
+		uniform_real_distribution<double> unit(0, 1);
+
+		for (;;) {
+			double u = _hn + unit(gen) * (_hx1 - _hn);
+			double x = Hinv(u);
+			double k = min(max(floor(x + 0.5), 1.0), _n);
+
+			if ((k - x <= _c) || (u >= H(k + 0.5) - h(k)))
+				return static_cast<uint64_t>(k);
+		}
+	}
+};
+
+/*
+ * Fill input with n keys of the given distribution.
+ */
+static void
+generate(distribution dist, size_t n, uint64_t seed, vector<int> &input)
+{
+	xoshiro256pp gen(seed);
+
+	input.resize(n);
+
+	switch (dist) {
+		case SORTED:
+			for (size_t i = 0; i < n; ++i)
+				input[i] = static_cast<int>(i);
+			break;
+
+		case REVERSE:
+			for (size_t i = 0; i < n; ++i)
+				input[i] = static_cast<int>(n - 1 - i);
+			break;
+
+		case FEW_UNIQUE: {
+			uniform_int_distribution<int> keys(0, few_unique_keys - 1);
+			for (auto &v : input)
+				v = keys(gen);
+			break;
+		}
+
+		case ORGAN_PIPE:
+			for (size_t i = 0; i < n; ++i)
+				input[i] = static_cast<int>(min(i, n - 1 - i));
+			break;
+
+		case BURSTS:
+			for (size_t i = 0; i < n; ++i)
+				input[i] = static_cast<int>(i);
+			for (size_t b = 0; b < max<size_t>(n / burst_every, 1); ++b) {
+				size_t start = uniform_below(gen, n);
+				fisher_yates(input.data() + start, input.data() + min(start + burst_size, n), gen);
+			}
+			break;
+
+		case ZIPF: {
+			zipf_distribution keys(min<uint64_t>(n, INT_MAX), 1.0);
+			for (auto &v : input)
+				v = static_cast<int>(keys(gen));
+			break;
+		}
+
+		case RANDOM:
+		default: {
+			uniform_int_distribution<int> keys(INT_MIN, INT_MAX);
+			for (auto &v : input)
+				v = keys(gen);
+			break;
+		}
+	}
+}
+
+/*
+ * The sorts under test. quadratic sorts take O(n^2) time on any input,
+ * first_pivot ones (the quick sorts, whose pivot is the first element) on
+ * sorted, reverse, organ pipe and bursts inputs; both are only run up to
+ * -max_quadratic elements.
+ */
+template<typename T>
+struct algorithm_entry
+{
+	const char *name;
+	bool quadratic;
+	bool first_pivot;
+	void (*sort)(vector<T> &elements, size_t nthreads);
+};
+
+static const algorithm_entry<int> algorithms[] = {
+	{ "bubble", true, false, [](vector<int> &e, size_t) { bubble_sort(e); } },
+	{ "selection", true, false, [](vector<int> &e, size_t) { selection_sort(e); } },
+	{ "insertion", true, false, [](vector<int> &e, size_t) { insertion_sort(e); } },
+	{ "merge_v1", false, false, [](vector<int> &e, size_t) { merge_sort_v1(e); } },
+	{ "merge_v2", false, false, [](vector<int> &e, size_t) { merge_sort_v2(e); } },
+	{ "merge_parallel", false, false, [](vector<int> &e, size_t t) { parallel_merge_sort(e, t); } },
+	{ "merge_power", false, false, [](vector<int> &e, size_t) { power_sort(e); } },
+	{ "quick_v1", false, true, [](vector<int> &e, size_t) { quick_sort_v1(e); } },
+	{ "quick_v2", false, true, [](vector<int> &e, size_t) { quick_sort_v2(e); } },
+	{ "intro", false, false, [](vector<int> &e, size_t) { intro_sort(e); } },
+	{ "sample", false, false, [](vector<int> &e, size_t t) { parallel_sample_sort(e, t); } },
+	{ "heap", false, false, [](vector<int> &e, size_t) { heap_sort(e); } },
+	{ "dary_heap4", false, false, [](vector<int> &e, size_t) { dary_heap_sort<4>(e); } },
+	{ "dary_heap8", false, false, [](vector<int> &e, size_t) { dary_heap_sort<8>(e); } },
+	{ "lsd_radix_int", false, false, [](vector<int> &e, size_t) { lsd_radix_sort(e); } },
+	{ "lsd_radix_parallel", false, false, [](vector<int> &e, size_t t) { lsd_radix_sort(e, 8, t); } },
+	{ "std::sort", false, false, [](vector<int> &e, size_t) { sort(e.begin(), e.end()); } },
+	{ "std::stable_sort", false, false, [](vector<int> &e, size_t) { stable_sort(e.begin(), e.end()); } },
+};
+
+/*
+ * A 100 byte record with an int key, for the -records inputs.
+ */
+struct record
+{
+	int key;
+	char payload[96];
+};
+
+static inline bool
+operator<(const record &a, const record &b)
+{
+	return a.key < b.key;
+}
+
+static int
+record_key(const record &r)
+{
+	return r.key;
+}
+
+/*
+ * Sorts of records: moving the records, or sorting (key, index) pairs and
+ * moving every record once (argsort.h).
+ */
+static const algorithm_entry<record> record_algorithms[] = {
+	{ "merge_power", false, false, [](vector<record> &e, size_t) { power_sort(e); } },
+	{ "intro", false, false, [](vector<record> &e, size_t) { intro_sort(e); } },
+	{ "sort_by_key_radix", false, false, [](vector<record> &e, size_t) { sort_by_key(e, record_key, KEY_RADIX); } },
+	{ "sort_by_key_quick", false, false, [](vector<record> &e, size_t) { sort_by_key(e, record_key, KEY_QUICK); } },
+	{ "std::sort", false, false, [](vector<record> &e, size_t) { sort(e.begin(), e.end()); } },
+	{ "std::stable_sort", false, false, [](vector<record> &e, size_t) { stable_sort(e.begin(), e.end()); } },
+};
+
+/*
+ * Two-sided 95% quantile of Student's t distribution with df degrees of
+ * freedom.
+ */
+static double
+student_t95(size_t df)
+{
+	static const double t[] = {
+		12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+		2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+		2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+	};
+
+	if (df == 0)
+		return 0;
+	if (df <= sizeof(t) / sizeof(t[0]))
+		return t[df - 1];
+	if (df <= 60)
+		return 2.000;
+	if (df <= 120)
+		return 1.980;
+	return 1.960;
+}
+
+/*
+ * Sort fresh copies of input reps times and print a CSV line: the mean
+ * time per element, the half width of its 95% confidence interval and the
+ * fastest repetition.
+ *
+ * @return false if a result is not sorted.
+ */
+template<typename T>
+static bool
+measure(const char *dist, const algorithm_entry<T> &algo, const vector<T> &input, int reps, size_t nthreads)
+{
+	vector<T> elements;
+	vector<double> ns(reps);
+
+	for (int r = 0; r < reps; ++r) {
+		elements = input;
+
+		chrono::time_point<chrono::high_resolution_clock> start = chrono::high_resolution_clock::now();
+		algo.sort(elements, nthreads);
+		chrono::time_point<chrono::high_resolution_clock> stop = chrono::high_resolution_clock::now();
+
+		if (!is_sorted(elements.begin(), elements.end())) {
+			cerr << algo.name << " did not sort the " << dist << " input of "
+				<< input.size() << " elements" << endl;
+			return false;
+		}
+
+		ns[r] = static_cast<double>(chrono::duration_cast<chrono::nanoseconds>(stop - start).count())
+			/ max<size_t>(input.size(), 1);
+	}
+
+	double mean = 0;
+	double var = 0;
+
+	for (double x : ns)
+		mean += x;
+	mean /= reps;
+
+	for (double x : ns)
+		var += (x - mean) * (x - mean);
+	if (reps > 1)
+		var /= reps - 1;
+
+	double ci = student_t95(reps - 1) * sqrt(var / reps);
+
+	cout << dist << "," << input.size() << "," << algo.name << "," << reps << ","
+		<< fixed << setprecision(3) << mean << "," << ci << ","
+		<< *min_element(ns.begin(), ns.end()) << endl;
+	return true;
+}
+
+/*
+ * Is name in the comma separated list (an empty list has every name)?
+ */
+static bool
+selected(const string &list, const char *name)
+{
+	if (list.empty())
+		return true;
+
+	size_t b = 0;
+	while (b <= list.size()) {
+		size_t e = list.find(',', b);
+		if (e == string::npos)
+			e = list.size();
+		if (list.compare(b, e - b, name) == 0)
+			return true;
+		b = e + 1;
+	}
+	return false;
+}
+
+/*
+ * Parse a comma separated list of sizes; 1e6 and the like are allowed.
+ */
+static bool
+parse_sizes(const char *arg, vector<size_t> &sizes)
+{
+	const char *p = arg;
+
+	sizes.clear();
+	for (;;) {
+		char *end;
+		double v = strtod(p, &end);
+
+		if ((end == p) || (v < 1) || (v != floor(v)))
+			return false;
+		sizes.push_back(static_cast<size_t>(v));
+
+		if (*end == '\0')
+			return true;
+		if (*end != ',')
+			return false;
+		p = end + 1;
+	}
+}
+
+static int
+usage(const char *progname)
+{
+	cerr << progname << " [-n <n>[,<n>...]] [-dist <name>[,...]] [-algo <name>[,...]] [-reps <count>]" << endl
+		<< "          [-seed <seed>] [-threads <n>] [-max_quadratic <n>] [-records]" << endl
+		<< "    -n <n>[,<n>...]     Input sizes, like 1e3,1e6 (default 1e3,1e4,1e5,1e6)." << endl
+		<< "    -dist <name>[,...]  Inputs: sorted, reverse, few_unique, organ_pipe, bursts," << endl
+		<< "                        zipf, random (default all)." << endl
+		<< "    -algo <name>[,...]  Sorts: bubble, selection, insertion, merge_v1, merge_v2," << endl
+		<< "                        merge_parallel, merge_power, quick_v1, quick_v2, intro, sample, heap," << endl
+		<< "                        dary_heap4, dary_heap8, lsd_radix_int, lsd_radix_parallel, std::sort," << endl
+		<< "                        std::stable_sort (default all)." << endl
+		<< "    -reps <count>       Repetitions per sort and input (default 5)." << endl
+		<< "    -seed <seed>        Random seed (default 1)." << endl
+		<< "    -threads <n>        Threads of the parallel sorts (default one per core)." << endl
+		<< "    -max_quadratic <n>  Largest input of the O(n^2) cases (default 10000)." << endl
+		<< "    -records            Sort 100 byte records with the input as keys, with merge_power," << endl
+		<< "                        intro, sort_by_key_radix, sort_by_key_quick, std::sort and" << endl
+		<< "                        std::stable_sort." << endl;
+	return 1;
+}
+
+int
+main(int argc, const char **argv)
+{
+	vector<size_t> sizes = { 1000, 10000, 100000, 1000000 };
+	string dists;
+	string algos;
+	int reps = 5;
+	uint64_t seed = 1;
+	size_t nthreads = 0;
+	size_t max_quadratic = 10000;
+	bool records = false;
+
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "-records") == 0) {
+			records = true;
+			continue;
+		}
+
+		if (argv[i + 1] == nullptr) {
+			cerr << "missing argument for " << argv[i] << endl;
+			return usage(argv[0]);
+		}
+
+		if (strcmp(argv[i], "-n") == 0) {
+			if (!parse_sizes(argv[++i], sizes)) {
+				cerr << "invalid sizes " << argv[i] << endl;
+				return usage(argv[0]);
+			}
+		} else if (strcmp(argv[i], "-dist") == 0) {
+			dists = argv[++i];
+		} else if (strcmp(argv[i], "-algo") == 0) {
+			algos = argv[++i];
+		} else if (strcmp(argv[i], "-reps") == 0) {
+			reps = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "-seed") == 0) {
+			seed = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-threads") == 0) {
+			nthreads = strtoull(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "-max_quadratic") == 0) {
+			max_quadratic = static_cast<size_t>(strtod(argv[++i], nullptr));
+		} else {
+			return usage(argv[0]);
+		}
+	}
+
+	if (reps < 1)
+		return usage(argv[0]);
+
+	cout << "distribution,n,algorithm,reps,ns_per_elem,ci95,min_ns_per_elem" << endl;
+
+	vector<int> input;
+	vector<record> rinput;
+	bool ok = true;
+
+	for (int d = 0; d < NDISTRIBUTIONS; ++d) {
+		distribution dist = static_cast<distribution>(d);
+		bool presorted = (dist == SORTED) || (dist == REVERSE) || (dist == ORGAN_PIPE) || (dist == BURSTS);
+
+		if (!selected(dists, distribution_names[d]))
+			continue;
+
+		for (size_t n : sizes) {
+			generate(dist, n, seed, input);
+
+			if (records) {
+				rinput.resize(n);
+				for (size_t i = 0; i < n; ++i) {
+					rinput[i].key = input[i];
+					memset(rinput[i].payload, static_cast<int>(i), sizeof(rinput[i].payload));
+				}
+				vector<int>().swap(input);
+
+				for (const algorithm_entry<record> &algo : record_algorithms) {
+					if (selected(algos, algo.name))
+						ok = measure(distribution_names[d], algo, rinput, reps, nthreads) && ok;
+				}
+				continue;
+			}
+
+			for (const algorithm_entry<int> &algo : algorithms) {
+				if (!selected(algos, algo.name))
+					continue;
+				if ((algo.quadratic || (algo.first_pivot && presorted)) && (n > max_quadratic))
+					continue;
+
+				ok = measure(distribution_names[d], algo, input, reps, nthreads) && ok;
+			}
+		}
+	}
+
+	return ok ? 0 : 1;
+}
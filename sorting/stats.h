@@ -0,0 +1,204 @@
+#if !defined(SORT_STATS_H_)
+#define SORT_STATS_H_
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace std;
+
+template<typename T>
+static ostream &
+operator<< (ostream &os, const vector<T> &values)
+{
+	typename vector<T>::const_iterator it;
+	for (it = values.begin(); it != values.end(); ++it) {
+		if (it != values.begin())
+			os << ", ";
+		os << *it;
+	}
+	return os;
+}
+
+/*
+ * Instrumentation policies of the sorts in sort.cpp. A sort takes the
+ * policy as a template parameter and tells it about every
+ * - compare(): comparison of two elements,
+ * - swap():    exchange of two elements,
+ * - copy():    element copied (merges),
+ * - step():    end of a pass, partition, merge or sink,
+ * - phase():   start of a phase of the sort (heap sort).
+ *
+ * no_stats does nothing, so the calls compile away and the sorts are as
+ * fast as without them. counting_stats adds the counts up; tracing_stats
+ * also prints the elements and the counts of every step.
+ *
+ * enabled tells a sort whether anything is counted; if not, it may take
+ * faster paths (the SIMD kernels) that report nothing.
+ */
+struct no_stats
+{
+	static constexpr bool enabled = false;
+
+	void compare() {}
+	void swap() {}
+	void copy() {}
+	void phase(const char *) {}
+
+	template<typename T>
+	void step(size_t, const vector<T> &) {}
+
+	template<typename T>
+	void step(size_t, size_t, size_t, const vector<T> &, bool = false) {}
+};
+
+class counting_stats
+{
+protected:
+	/*
+	 * Counts of the current step.
+	 */
+	size_t _ncmp;
+	size_t _nswap;
+	size_t _ncopy;
+
+	/*
+	 * Counts of the steps before.
+	 */
+	size_t _tcmp;
+	size_t _tswap;
+	size_t _tcopy;
+	size_t _nsteps;
+
+	void end_step()
+	{
+		_tcmp += _ncmp;
+		_tswap += _nswap;
+		_tcopy += _ncopy;
+		_nsteps++;
+		_ncmp = _nswap = _ncopy = 0;
+	}
+
+public:
+	static constexpr bool enabled = true;
+
+	counting_stats() : _ncmp(0), _nswap(0), _ncopy(0), _tcmp(0), _tswap(0), _tcopy(0), _nsteps(0)
+	{
+	}
+
+	void compare()
+	{
+		_ncmp++;
+	}
+
+	void swap()
+	{
+		_nswap++;
+	}
+
+	void copy()
+	{
+		_ncopy++;
+	}
+
+	void phase(const char *)
+	{
+	}
+
+	template<typename T>
+	void step(size_t, const vector<T> &)
+	{
+		end_step();
+	}
+
+	template<typename T>
+	void step(size_t, size_t, size_t, const vector<T> &, bool = false)
+	{
+		end_step();
+	}
+
+	size_t comparisons() const
+	{
+		return _tcmp + _ncmp;
+	}
+
+	size_t swaps() const
+	{
+		return _tswap + _nswap;
+	}
+
+	size_t copies() const
+	{
+		return _tcopy + _ncopy;
+	}
+
+	size_t steps() const
+	{
+		return _nsteps;
+	}
+
+	/*
+	 * Print the totals, and the memory traffic they stand for: a swap
+	 * moves an element three times, a copy once.
+	 *
+	 * @param [inout] os        - where to print.
+	 * @param [in]    n         - number of elements sorted.
+	 * @param [in]    elem_size - size of an element in bytes.
+	 */
+	void report(ostream &os, size_t n, size_t elem_size) const
+	{
+		size_t moves = 3 * swaps() + copies();
+
+		os << "comparisons = " << comparisons() << ", swaps = " << swaps()
+			<< ", copies = " << copies() << ", steps = " << steps() << endl;
+		os << "bytes moved = " << moves * elem_size;
+		if (n > 0) {
+			os << fixed << setprecision(2)
+				<< ", comparisons/element = " << static_cast<double>(comparisons()) / n
+				<< ", moves/element = " << static_cast<double>(moves) / n;
+		}
+		os << endl;
+	}
+};
+
+class tracing_stats : public counting_stats
+{
+public:
+	void phase(const char *name)
+	{
+		cout << "----- " << name << " -----" << endl;
+	}
+
+	template<typename T>
+	void step(size_t iter, const vector<T> &elements)
+	{
+		cout << "iteration = " << setw(2) << iter << " ( " <<  elements <<
+			" ) comparisons = " << setw(2) << _ncmp << ", swap = " << setw(2) << _nswap << endl;
+		end_step();
+	}
+
+	template<typename T>
+	void step(size_t iter, size_t lo, size_t hi, const vector<T> &elements, bool copies = false)
+	{
+		cout << "iteration = " << setw(2) << iter <<
+			", lo = " << setw(2) << lo << ", hi = " << setw(2) << hi <<
+			" ( " <<  elements << " ) comparisons = " << setw(2) << _ncmp;
+		if (copies)
+			cout << ", copies = " << setw(2) << _ncopy << endl;
+		else
+			cout << ", swaps = " << setw(2) << _nswap << endl;
+		end_step();
+	}
+};
+
+/*
+ * The policy of the sorts when none is given: a DEBUG build traces every
+ * step, any other build compiles the statistics out.
+ */
+#if defined(DEBUG)
+typedef tracing_stats sort_stats;
+#else
+typedef no_stats sort_stats;
+#endif
+
+#endif // SORT_STATS_H_